@@ -0,0 +1,344 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/** Timing of the doTransform, toMsg and fromMsg conversions of the tf2 conversion packages.
+ * Every case is run for at least --min-time seconds, once on a single object and once over a batch,
+ * and written as a CSV line, so runs can be compared by scripts:
+ *   package,type,operation,objects,iterations,seconds,ns_per_object
+ * Only cases whose "package,type,operation" contains the optional filter argument are run.
+ */
+
+#include <tf2/convert.h>
+#include <tf2_bullet/tf2_bullet.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_kdl/tf2_kdl.h>
+#include <tf2_sensor_msgs/tf2_sensor_msgs.h>
+#include <ros/time.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/** \brief Keeps the compiler from dropping results which are never read */
+template <class T>
+inline void escape(T& value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+class Benchmark
+{
+public:
+  static const size_t BATCH_SIZE = 1000;
+
+  Benchmark(double min_time, const std::string& filter)
+  : min_time_(min_time)
+  , filter_(filter)
+  {
+    printf("package,type,operation,objects,iterations,seconds,ns_per_object\n");
+  }
+
+  /** \brief Time f, which handles objects objects per call */
+  template <class F>
+  void run(const char* package, const char* type, const std::string& operation, size_t objects, F f)
+  {
+    std::string name = std::string(package) + "," + type + "," + operation;
+    if (!filter_.empty() && name.find(filter_) == std::string::npos)
+      return;
+
+    // Warm up caches and allocations, then read the clock only every chunk of calls
+    f();
+    size_t iterations = 0;
+    size_t chunk = 1;
+    double elapsed = 0.0;
+    ros::WallTime start = ros::WallTime::now();
+    while (elapsed < min_time_)
+    {
+      for (size_t i = 0; i < chunk; ++i)
+        f();
+      iterations += chunk;
+      chunk *= 2;
+      elapsed = (ros::WallTime::now() - start).toSec();
+    }
+    printf("%s,%lu,%lu,%.6f,%.2f\n", name.c_str(), (unsigned long)objects, (unsigned long)iterations, elapsed,
+           elapsed * 1e9 / ((double)iterations * objects));
+    fflush(stdout);
+  }
+
+  /** \brief Time op(input, output) on one object and on a batch of BATCH_SIZE copies */
+  template <class In, class Out, class Op>
+  void runConversion(const char* package, const char* type, const char* operation, const In& input, Op op)
+  {
+    Out output;
+    run(package, type, operation, 1, [&]() { op(input, output); escape(output); });
+
+    // Fixed size Eigen types need aligned storage, which does not hurt the others
+    std::vector<In, Eigen::aligned_allocator<In> > inputs(BATCH_SIZE, input);
+    std::vector<Out, Eigen::aligned_allocator<Out> > outputs(BATCH_SIZE);
+    run(package, type, std::string(operation) + " batch", BATCH_SIZE, [&]()
+    {
+      for (size_t i = 0; i < BATCH_SIZE; ++i)
+        op(inputs[i], outputs[i]);
+      escape(outputs);
+    });
+  }
+
+  /** \brief Time tf2::doTransform of input */
+  template <class T>
+  void runDoTransform(const char* package, const char* type, const T& input, const geometry_msgs::TransformStamped& transform)
+  {
+    runConversion<T, T>(package, type, "doTransform", input,
+                        [&transform](const T& in, T& out) { tf2::doTransform(in, out, transform); });
+  }
+
+private:
+  double min_time_;
+  std::string filter_;
+};
+
+static geometry_msgs::TransformStamped makeTransform()
+{
+  geometry_msgs::TransformStamped t;
+  t.header.stamp = ros::Time(2.0);
+  t.header.frame_id = "map";
+  t.child_frame_id = "base_link";
+  t.transform.translation.x = 1.0;
+  t.transform.translation.y = 2.0;
+  t.transform.translation.z = 3.0;
+  // 90 degrees about z
+  t.transform.rotation.z = std::sqrt(0.5);
+  t.transform.rotation.w = std::sqrt(0.5);
+  return t;
+}
+
+static std_msgs::Header makeHeader()
+{
+  std_msgs::Header header;
+  header.stamp = ros::Time(2.0);
+  header.frame_id = "base_link";
+  return header;
+}
+
+static sensor_msgs::PointCloud2 makeCloud(size_t size)
+{
+  sensor_msgs::PointCloud2 cloud;
+  cloud.header = makeHeader();
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(size);
+  sensor_msgs::PointCloud2Iterator<float> x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> z(cloud, "z");
+  for (size_t i = 0; i < size; ++i, ++x, ++y, ++z)
+  {
+    *x = 0.001f * i;
+    *y = 1.0f;
+    *z = -0.5f * i;
+  }
+  return cloud;
+}
+
+static void geometryMsgsCases(Benchmark& b, const geometry_msgs::TransformStamped& t)
+{
+  const char* p = "tf2_geometry_msgs";
+
+  geometry_msgs::Point point;
+  point.x = 1.0;
+  point.y = 2.0;
+  point.z = 3.0;
+  b.runDoTransform(p, "Point", point, t);
+
+  geometry_msgs::PointStamped point_stamped;
+  point_stamped.header = makeHeader();
+  point_stamped.point = point;
+  b.runDoTransform(p, "PointStamped", point_stamped, t);
+
+  geometry_msgs::Vector3Stamped vector_stamped;
+  vector_stamped.header = makeHeader();
+  vector_stamped.vector.x = 1.0;
+  b.runDoTransform(p, "Vector3Stamped", vector_stamped, t);
+
+  geometry_msgs::QuaternionStamped quaternion_stamped;
+  quaternion_stamped.header = makeHeader();
+  quaternion_stamped.quaternion.w = 1.0;
+  b.runDoTransform(p, "QuaternionStamped", quaternion_stamped, t);
+
+  geometry_msgs::PoseStamped pose_stamped;
+  pose_stamped.header = makeHeader();
+  pose_stamped.pose.position = point;
+  pose_stamped.pose.orientation.w = 1.0;
+  b.runDoTransform(p, "Pose", pose_stamped.pose, t);
+  b.runDoTransform(p, "PoseStamped", pose_stamped, t);
+
+  geometry_msgs::PoseWithCovarianceStamped pose_covariance;
+  pose_covariance.header = makeHeader();
+  pose_covariance.pose.pose = pose_stamped.pose;
+  for (size_t i = 0; i < 36; ++i)
+    pose_covariance.pose.covariance[i] = (i % 7 == 0) ? 1.0 : 0.1;
+  b.runDoTransform(p, "PoseWithCovarianceStamped", pose_covariance, t);
+
+  geometry_msgs::TransformStamped transform_stamped = t;
+  transform_stamped.header.frame_id = "base_link";
+  transform_stamped.child_frame_id = "tool";
+  b.runDoTransform(p, "TransformStamped", transform_stamped, t);
+
+  geometry_msgs::WrenchStamped wrench_stamped;
+  wrench_stamped.header = makeHeader();
+  wrench_stamped.wrench.force.x = 1.0;
+  wrench_stamped.wrench.torque.z = 1.0;
+  b.runDoTransform(p, "WrenchStamped", wrench_stamped, t);
+
+  tf2::Vector3 vector(1.0, 2.0, 3.0);
+  b.runConversion<tf2::Vector3, geometry_msgs::Vector3>(p, "Vector3", "toMsg", vector,
+      [](const tf2::Vector3& in, geometry_msgs::Vector3& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::Vector3, tf2::Vector3>(p, "Vector3", "fromMsg", tf2::toMsg(vector),
+      [](const geometry_msgs::Vector3& in, tf2::Vector3& out) { tf2::fromMsg(in, out); });
+
+  tf2::Transform transform(tf2::Quaternion(0.0, 0.0, std::sqrt(0.5), std::sqrt(0.5)), vector);
+  b.runConversion<tf2::Transform, geometry_msgs::Transform>(p, "Transform", "toMsg", transform,
+      [](const tf2::Transform& in, geometry_msgs::Transform& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::Transform, tf2::Transform>(p, "Transform", "fromMsg", t.transform,
+      [](const geometry_msgs::Transform& in, tf2::Transform& out) { tf2::fromMsg(in, out); });
+
+  tf2::Stamped<tf2::Transform> stamped_transform(transform, ros::Time(2.0), "base_link");
+  b.runConversion<tf2::Stamped<tf2::Transform>, geometry_msgs::PoseWithCovarianceStamped>(p, "PoseWithCovarianceStamped", "toMsg",
+      stamped_transform, [](const tf2::Stamped<tf2::Transform>& in, geometry_msgs::PoseWithCovarianceStamped& out) { tf2::toMsg(in, out); });
+  b.runConversion<geometry_msgs::PoseWithCovarianceStamped, tf2::Stamped<tf2::Transform> >(p, "PoseWithCovarianceStamped", "fromMsg",
+      pose_covariance, [](const geometry_msgs::PoseWithCovarianceStamped& in, tf2::Stamped<tf2::Transform>& out) { tf2::fromMsg(in, out); });
+}
+
+static void eigenCases(Benchmark& b, const geometry_msgs::TransformStamped& t)
+{
+  const char* p = "tf2_eigen";
+
+  Eigen::Vector3d vector(1.0, 2.0, 3.0);
+  b.runDoTransform(p, "Vector3d", vector, t);
+  b.runDoTransform(p, "Stamped<Vector3d>", tf2::Stamped<Eigen::Vector3d>(vector, ros::Time(2.0), "base_link"), t);
+
+  Eigen::Isometry3d isometry = Eigen::Translation3d(vector) * Eigen::Quaterniond(std::sqrt(0.5), 0.0, 0.0, std::sqrt(0.5));
+  b.runDoTransform(p, "Isometry3d", isometry, t);
+  Eigen::Affine3d affine(isometry.matrix());
+  b.runDoTransform(p, "Affine3d", affine, t);
+
+  b.runConversion<Eigen::Vector3d, geometry_msgs::Point>(p, "Vector3d", "toMsg", vector,
+      [](const Eigen::Vector3d& in, geometry_msgs::Point& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::Point, Eigen::Vector3d>(p, "Vector3d", "fromMsg", tf2::toMsg(vector),
+      [](const geometry_msgs::Point& in, Eigen::Vector3d& out) { tf2::fromMsg(in, out); });
+  b.runConversion<Eigen::Isometry3d, geometry_msgs::Pose>(p, "Isometry3d", "toMsg", isometry,
+      [](const Eigen::Isometry3d& in, geometry_msgs::Pose& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::Pose, Eigen::Isometry3d>(p, "Isometry3d", "fromMsg", tf2::toMsg(isometry),
+      [](const geometry_msgs::Pose& in, Eigen::Isometry3d& out) { tf2::fromMsg(in, out); });
+}
+
+static void kdlCases(Benchmark& b, const geometry_msgs::TransformStamped& t)
+{
+  const char* p = "tf2_kdl";
+
+  tf2::Stamped<KDL::Vector> vector(KDL::Vector(1.0, 2.0, 3.0), ros::Time(2.0), "base_link");
+  b.runDoTransform(p, "Stamped<Vector>", vector, t);
+  tf2::Stamped<KDL::Frame> frame(KDL::Frame(KDL::Rotation::RotZ(M_PI / 2), KDL::Vector(1.0, 2.0, 3.0)), ros::Time(2.0), "base_link");
+  b.runDoTransform(p, "Stamped<Frame>", frame, t);
+  tf2::Stamped<KDL::Twist> twist(KDL::Twist(KDL::Vector(1.0, 0.0, 0.0), KDL::Vector(0.0, 0.0, 1.0)), ros::Time(2.0), "base_link");
+  b.runDoTransform(p, "Stamped<Twist>", twist, t);
+  tf2::Stamped<KDL::Wrench> wrench(KDL::Wrench(KDL::Vector(1.0, 0.0, 0.0), KDL::Vector(0.0, 0.0, 1.0)), ros::Time(2.0), "base_link");
+  b.runDoTransform(p, "Stamped<Wrench>", wrench, t);
+
+  b.runConversion<tf2::Stamped<KDL::Frame>, geometry_msgs::PoseStamped>(p, "Stamped<Frame>", "toMsg", frame,
+      [](const tf2::Stamped<KDL::Frame>& in, geometry_msgs::PoseStamped& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::PoseStamped, tf2::Stamped<KDL::Frame> >(p, "Stamped<Frame>", "fromMsg", tf2::toMsg(frame),
+      [](const geometry_msgs::PoseStamped& in, tf2::Stamped<KDL::Frame>& out) { tf2::fromMsg(in, out); });
+}
+
+static void bulletCases(Benchmark& b, const geometry_msgs::TransformStamped& t)
+{
+  const char* p = "tf2_bullet";
+
+  tf2::Stamped<btVector3> vector(btVector3(1.0, 2.0, 3.0), ros::Time(2.0), "base_link");
+  b.runDoTransform(p, "Stamped<btVector3>", vector, t);
+  b.runConversion<tf2::Stamped<btVector3>, geometry_msgs::PointStamped>(p, "Stamped<btVector3>", "toMsg", vector,
+      [](const tf2::Stamped<btVector3>& in, geometry_msgs::PointStamped& out) { out = tf2::toMsg(in); });
+  b.runConversion<geometry_msgs::PointStamped, tf2::Stamped<btVector3> >(p, "Stamped<btVector3>", "fromMsg", tf2::toMsg(vector),
+      [](const geometry_msgs::PointStamped& in, tf2::Stamped<btVector3>& out) { tf2::fromMsg(in, out); });
+}
+
+static void sensorMsgsCases(Benchmark& b, const geometry_msgs::TransformStamped& t)
+{
+  // Clouds are batches of their own, so they are timed per point at several sizes
+  static const size_t sizes[] = {1000, 10000, 100000, 1000000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+  {
+    sensor_msgs::PointCloud2 cloud_in = makeCloud(sizes[i]);
+    sensor_msgs::PointCloud2 cloud_out;
+    char operation[64];
+    snprintf(operation, sizeof(operation), "doTransform %lu points", (unsigned long)sizes[i]);
+    b.run("tf2_sensor_msgs", "PointCloud2", operation, sizes[i], [&]()
+    {
+      tf2::doTransform(cloud_in, cloud_out, t);
+      escape(cloud_out);
+    });
+  }
+}
+
+int main(int argc, char** argv)
+{
+  double min_time = 0.2;
+  std::string filter;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+      min_time = atof(argv[++i]);
+    else if (argv[i][0] != '-' && filter.empty())
+      filter = argv[i];
+    else
+    {
+      fprintf(stderr, "Usage: conversion_benchmark [--min-time seconds] [filter]\n");
+      return -1;
+    }
+  }
+
+  ros::Time::init();
+  Benchmark b(min_time, filter);
+  geometry_msgs::TransformStamped t = makeTransform();
+  geometryMsgsCases(b, t);
+  eigenCases(b, t);
+  kdlCases(b, t);
+  bulletCases(b, t);
+  sensorMsgsCases(b, t);
+  return 0;
+}
@@ -154,6 +154,63 @@ TEST(MessageFilter, postTransforms)
   EXPECT_EQ(1, n.count_);
 }
 
+TEST(MessageFilter, waitStatistics)
+{
+  BufferCore bc;
+  Notification n(1);
+  MessageFilter<geometry_msgs::PointStamped> filter(bc, "frame1", 1, 0);
+  filter.registerCallback(boost::bind(&Notification::notify, &n, _1));
+
+  ros::Time stamp(1);
+  geometry_msgs::PointStampedPtr msg(new geometry_msgs::PointStamped);
+  msg->header.stamp = stamp;
+  msg->header.frame_id = "frame2";
+  filter.add(msg);
+
+  // Pushed out of the queue by the next one
+  msg.reset(new geometry_msgs::PointStamped);
+  msg->header.stamp = stamp + ros::Duration(1);
+  msg->header.frame_id = "frame2";
+  filter.add(msg);
+
+  ros::WallDuration(0.01).sleep();
+  bc.setTransform(createTransform(Quaternion(0,0,0,1), Vector3(1,2,3), stamp, "frame1", "frame2"), "me");
+  bc.setTransform(createTransform(Quaternion(0,0,0,1), Vector3(1,2,3), stamp + ros::Duration(1), "frame1", "frame2"), "me");
+  EXPECT_EQ(1, n.count_);
+
+  typedef MessageFilter<geometry_msgs::PointStamped>::WaitStatisticsKey Key;
+  MessageFilter<geometry_msgs::PointStamped>::M_WaitStatistics statistics = filter.getWaitStatistics();
+  ASSERT_EQ(1u, statistics.size());
+  const WaitStatistics& frame2 = statistics[Key("frame2", filter.getTargetFramesString())];
+  EXPECT_EQ(1u, frame2.ready_count);
+  EXPECT_EQ(1u, frame2.dropped_count);
+  EXPECT_GE(frame2.max_wait, 0.01);
+
+  // Messages waiting for other target frames are counted apart
+  filter.setTargetFrame("frame2");
+  msg.reset(new geometry_msgs::PointStamped);
+  msg->header.stamp = stamp;
+  msg->header.frame_id = "frame2";
+  filter.add(msg);
+  EXPECT_EQ(2, n.count_);
+  statistics = filter.getWaitStatistics();
+  ASSERT_EQ(2u, statistics.size());
+  EXPECT_EQ(1u, statistics[Key("frame2", filter.getTargetFramesString())].ready_count);
+
+  tf2_msgs::MessageFilterStatistics stats_msg;
+  filter.getWaitStatistics(stats_msg);
+  EXPECT_EQ(filter.getTargetFramesString(), stats_msg.target_frames);
+  ASSERT_EQ(2u, stats_msg.sources.size());
+  EXPECT_EQ("frame2", stats_msg.sources[0].source_frame);
+  EXPECT_EQ("frame1 ", stats_msg.sources[0].target_frames);
+  EXPECT_EQ(2u, stats_msg.sources[0].ready_count + stats_msg.sources[0].dropped_count);
+  EXPECT_EQ("frame2 ", stats_msg.sources[1].target_frames);
+  EXPECT_EQ(size_t(WaitStatistics::NUM_BUCKETS), stats_msg.sources[0].bucket_counts.size());
+
+  filter.resetWaitStatistics();
+  EXPECT_TRUE(filter.getWaitStatistics().empty());
+}
+
 TEST(MessageFilter, queueSize)
 {
   BufferCore bc;
@@ -315,6 +372,36 @@ TEST(MessageFilter, emptyFrameIDFailure)
   EXPECT_EQ(1, n.failure_count_);
 }
 
+TEST(MessageFilter, timeoutFailure)
+{
+  BufferCore bc;
+  Notification n(1);
+  MessageFilter<geometry_msgs::PointStamped> filter(bc, "", 10, 0);
+  std::vector<std::string> target_frames;
+  target_frames.push_back("frame1");
+  target_frames.push_back("frame3");
+  filter.setTargetFrames(target_frames);
+  filter.setTimeout(ros::WallDuration(0.05));
+  filter.registerCallback(boost::bind(&Notification::notify, &n, _1));
+  filter.registerFailureCallback(boost::bind(&Notification::failure, &n, _1, _2));
+
+  geometry_msgs::PointStampedPtr msg(new geometry_msgs::PointStamped);
+  msg->header.stamp = ros::Time(1);
+  msg->header.frame_id = "frame2";
+  filter.add(msg);
+
+  // No transforms ever arrive, the message still leaves the queue once
+  ros::WallTime end = ros::WallTime::now() + ros::WallDuration(5.0);
+  while (n.failure_count_ == 0 && ros::WallTime::now() < end)
+  {
+    ros::WallDuration(0.01).sleep();
+  }
+  ros::WallDuration(0.1).sleep();
+
+  EXPECT_EQ(0, n.count_);
+  EXPECT_EQ(1, n.failure_count_);
+}
+
 TEST(MessageFilter, callbackQueue)
 {
   BufferCore bc;
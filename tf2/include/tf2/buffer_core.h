@@ -33,22 +33,30 @@
 #define TF2_BUFFER_CORE_H
 
 #include "transform_storage.h"
+#include "frame_registry.h"
 
 #include <boost/signals2.hpp>
 
+#include <algorithm>
 #include <string>
 
 #include "ros/duration.h"
 #include "ros/time.h"
 //#include "geometry_msgs/TwistStamped.h"
 #include "geometry_msgs/TransformStamped.h"
+#include "tf2_msgs/FrameHistory.h"
+#include "tf2_msgs/FrameInfo.h"
 
 //////////////////////////backwards startup for porting
 //#include "tf/tf.h"
 
 #include <boost/unordered_map.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 namespace tf2
@@ -60,11 +68,121 @@ typedef uint64_t TransformableRequestHandle;
 
 class TimeCacheInterface;
 typedef boost::shared_ptr<TimeCacheInterface> TimeCacheInterfacePtr;
+class WorkerPool;
+class TimerWheel;
 
 enum TransformableResult
 {
   TransformAvailable,
   TransformFailure,
+  /// The timeout given to addTransformableRequest passed first
+  TransformTimeout,
+};
+
+/** \brief Insertions of one frame from one authority which were rejected, see BufferCore::getRejectedDataCounts */
+struct RejectedDataCount
+{
+  std::string child_frame_id;
+  std::string authority;
+  /// Rejected insertions, including the ones whose warning was suppressed
+  uint32_t rejected;
+  /// Warnings emitted about them, at most one per report period
+  uint32_t reported;
+};
+
+/** \brief Scratch state of a lookup which callers can keep across calls.
+ * Hot loops which keep one LookupContext reuse its containers instead of allocating them on every
+ * lookup. A context holds no data between calls, but must not be used by two threads at the same time.
+ */
+class LookupContext
+{
+public:
+  /** \brief Why the last lookup through this context failed */
+  const std::string& getErrorString() const { return error_string_; }
+
+private:
+  friend class BufferCore;
+
+  std::vector<P_TimeAndFrameID> lct_cache_;
+  std::vector<CompactFrameID> source_frame_chain_;
+  std::vector<CompactFrameID> target_frame_chain_;
+  std::vector<CompactFrameID> reverse_frame_chain_;
+  std::string error_string_;
+};
+
+/** \brief A set of lookups which BufferCore::lookupTransforms answers together.
+ * Queries may mix targets, sources and times. They are answered under a single lock, and every
+ * (frame, time) edge and every path from a frame to the top of its tree is interpolated only once per
+ * execution, so queries which share part of their chain reuse it. Keeping the batch across cycles also
+ * keeps its memory. A batch must not be used by two threads at the same time.
+ */
+class LookupBatch
+{
+public:
+  /** \brief Add a lookup of the transform from source_frame to target_frame at time
+   * \return The index of the query in the results */
+  size_t add(const std::string& target_frame, const std::string& source_frame, const ros::Time& time);
+
+  /** \brief Add a lookup of the transform from source_frame at source_time to target_frame at
+   * target_time, assuming fixed_frame does not move
+   * \return The index of the query in the results */
+  size_t add(const std::string& target_frame, const ros::Time& target_time,
+             const std::string& source_frame, const ros::Time& source_time,
+             const std::string& fixed_frame);
+
+  /** \brief Remove all queries */
+  void clear();
+
+  /** \brief Number of queries */
+  size_t size() const { return queries_.size(); }
+
+  /** \brief The tf2_msgs::TF2Error code of query i, NO_ERROR if it succeeded */
+  int getError(size_t i) const { return queries_[i].error; }
+
+  /** \brief Why query i failed, empty if it succeeded */
+  const std::string& getErrorString(size_t i) const { return queries_[i].error_string; }
+
+  /** \brief The result of query i
+   * Throws the exception BufferCore::lookupTransform would have thrown if the query failed. */
+  const geometry_msgs::TransformStamped& getTransform(size_t i) const;
+
+private:
+  friend class BufferCore;
+
+  struct Query
+  {
+    std::string target_frame;
+    std::string source_frame;
+    std::string fixed_frame;
+    ros::Time target_time;
+    ros::Time source_time;
+    CompactFrameID target_id;
+    CompactFrameID source_id;
+    CompactFrameID fixed_id;
+    int error;
+    std::string error_string;
+    geometry_msgs::TransformStamped transform;
+  };
+
+  /** \brief Transform from a frame to the top of what can be walked at one time
+   * The top is the root of the tree, or the first frame whose transform to its parent can not be
+   * interpolated at that time, which is where walkToTopParent stops as well. */
+  struct PathToTop
+  {
+    /// False if the walk ran into a loop
+    bool valid;
+    CompactFrameID top;
+    tf2::Quaternion rotation;
+    tf2::Vector3 translation;
+  };
+
+  typedef std::pair<CompactFrameID, uint64_t> FrameAndTime;
+
+  std::vector<Query> queries_;
+  /// Paths found during one execution, so every edge is interpolated once
+  boost::unordered_map<FrameAndTime, PathToTop> paths_;
+  std::vector<std::pair<CompactFrameID, TransformStorage> > pending_path_;
+  LookupContext context_;
 };
 
 /** \brief A Class which provides coordinate transforms between any two frames in a system.
@@ -91,6 +209,7 @@ public:
   /************* Constants ***********************/
   static const int DEFAULT_CACHE_TIME = 10;  //!< The default amount of time to cache data in seconds
   static const uint32_t MAX_GRAPH_DEPTH = 1000UL;  //!< Maximum graph search depth (deeper graphs will be assumed to have loops)
+  static const int LOOKUP_BUSY = 255;  //!< Returned by tryLookupTransform when the buffer could not be locked in time
 
   /** Constructor
    * \param interpolating Whether to interpolate, if this is false the closest value will be returned
@@ -103,6 +222,14 @@ public:
   /** \brief Clear all data */
   void clear();
 
+  /** \brief Clear all data stamped later than time, keeping static transforms
+   * This is intended to recover from a jump back in time (e.g. a simulation reset or bag loop)
+   * without discarding the history which is still valid. Pending transformable requests are
+   * re-evaluated immediately afterwards.
+   * \param time The time which was jumped back to
+   */
+  void clearAfter(const ros::Time& time);
+
   /** \brief Add transform information to the tf data structure
    * \param transform The transform to store
    * \param authority The source of the information for this transform
@@ -111,6 +238,34 @@ public:
    */
   bool setTransform(const geometry_msgs::TransformStamped& transform, const std::string & authority, bool is_static = false);
 
+  /** \brief Add a batch of transforms to the tf data structure
+   * The transforms are inserted under a single lock and pending transformable requests are only
+   * evaluated once for the whole batch, which is cheaper than calling setTransform for each of them.
+   * \param transforms The transforms to store, e.g. all transforms of a tf2_msgs::TFMessage
+   * \param authority The source of the information for these transforms
+   * \param is_static Record these transforms as static transforms.
+   * \return True unless an error occured for any of the transforms
+   */
+  bool setTransforms(const std::vector<geometry_msgs::TransformStamped>& transforms, const std::string & authority, bool is_static = false);
+
+  /** \brief Get the cached samples of frames, e.g. to hand them to another buffer
+   * \param frames The child frames to get the history of, all frames if empty. Unknown frames are skipped.
+   * \param history How far back from the latest sample of each frame to go, everything cached if 0
+   * \param frame_history One entry per frame with data, samples oldest first
+   */
+  void getFrameHistory(const std::vector<std::string>& frames, const ros::Duration& history,
+                       std::vector<tf2_msgs::FrameHistory>& frame_history) const;
+
+  /** \brief Add the history of frames, as returned by getFrameHistory
+   * Samples go through the same checks as setTransforms. Samples older than the cache time of this
+   * buffer are dropped, and so are samples at or after the oldest one this buffer already has of a
+   * frame, which keeps live data received while the history was requested from counting as repeated.
+   * \param frame_history The history to insert
+   * \param authority The source of the information for these transforms
+   * \return True unless an error occured for any of the samples
+   */
+  bool setFrameHistory(const std::vector<tf2_msgs::FrameHistory>& frame_history, const std::string& authority);
+
   /*********** Accessors *************/
 
   /** \brief Get the transform between two frames by frame ID.
@@ -126,6 +281,45 @@ public:
     lookupTransform(const std::string& target_frame, const std::string& source_frame,
 		    const ros::Time& time) const;
 
+  /** \brief Get the transform between two frames by frame ID, reusing caller owned state.
+   * Same as lookupTransform above, but the result is written into transform, whose strings keep
+   * their capacity, and all intermediate containers come from context.
+   * \param target_frame The frame to which data should be transformed
+   * \param source_frame The frame where the data originated
+   * \param time The time at which the value of the transform is desired. (0 will get the latest)
+   * \param transform The transform between the frames
+   * \param context Scratch state to reuse across calls
+   *
+   * Possible exceptions tf2::LookupException, tf2::ConnectivityException,
+   * tf2::ExtrapolationException, tf2::InvalidArgumentException
+   */
+  void lookupTransform(const std::string& target_frame, const std::string& source_frame,
+		       const ros::Time& time, geometry_msgs::TransformStamped& transform, LookupContext& context) const;
+
+  /** \brief Get the transform between two frames without blocking for longer than max_wait
+   * Meant for real time threads. The buffer's lock is only waited for up to max_wait, a max_wait of
+   * 0 only tries it once, and nothing is thrown. Names are resolved without the lock, so the only
+   * other time spent is the walk of the tree itself.
+   * \param target_frame The frame to which data should be transformed
+   * \param source_frame The frame where the data originated
+   * \param time The time at which the value of the transform is desired. (0 will get the latest)
+   * \param max_wait How long to wait at most for writers to release the buffer
+   * \param transform The transform between the frames, only written on success
+   * \param context Scratch state to reuse across calls, its error string is retrieved with getErrorString
+   * \return tf2_msgs::TF2Error::NO_ERROR on success, LOOKUP_BUSY if the lock was not acquired in time,
+   * or the tf2_msgs::TF2Error code of the exception lookupTransform would have thrown
+   */
+  int tryLookupTransform(const std::string& target_frame, const std::string& source_frame,
+                         const ros::Time& time, const ros::WallDuration& max_wait,
+                         geometry_msgs::TransformStamped& transform, LookupContext& context) const;
+
+  /** \brief Answer all the queries of a batch together
+   * \param batch The queries, whose results are stored back into it
+   *
+   * Unlike lookupTransform nothing is thrown, each query records its own error, see LookupBatch.
+   */
+  void lookupTransforms(LookupBatch& batch) const;
+
   /** \brief Get the transform between two frames by frame ID assuming fixed frame.
    * \param target_frame The frame to which data should be transformed
    * \param target_time The time to which the data should be transformed. (0 will get the latest)
@@ -218,10 +412,23 @@ public:
   */
   std::string allFramesAsYAML() const;
 
+  /** \brief A way to see what frames have been cached without formatting them as text
+   * Fills one entry per frame with data, at full timestamp precision.
+   * Useful for debugging tools which process the frame graph programmatically.
+   */
+  void allFramesAsFrameInfo(std::vector<tf2_msgs::FrameInfo>& frames) const;
+
   /** \brief A way to see what frames have been cached
    * Useful for debugging
    */
   std::string allFramesAsString() const;
+
+  /** \brief Count the insertions rejected per child frame and authority since construction or the last clear()
+   * Rejected data is only warned about once per report period for each frame and authority, these counts
+   * include the insertions whose warning was suppressed.
+   * \param counts One entry per frame and authority which had data rejected
+   */
+  void getRejectedDataCounts(std::vector<RejectedDataCount>& counts) const;
   
   typedef boost::function<void(TransformableRequestHandle request_handle, const std::string& target_frame, const std::string& source_frame,
                                ros::Time time, TransformableResult result)> TransformableCallback;
@@ -230,8 +437,17 @@ public:
   TransformableCallbackHandle addTransformableCallback(const TransformableCallback& cb);
   /// \brief Internal use only
   void removeTransformableCallback(TransformableCallbackHandle handle);
-  /// \brief Internal use only
-  TransformableRequestHandle addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame, ros::Time time);
+  /** \brief Internal use only
+   * If timeout is not zero and the request is still pending once that much wall time has passed, its callback
+   * is called with TransformTimeout from a thread of the buffer. */
+  TransformableRequestHandle addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame, ros::Time time,
+                                                     const ros::WallDuration& timeout = ros::WallDuration());
+  /** \brief Internal use only
+   * Like addTransformableRequest for a single time, but the request only becomes transformable once both
+   * start_time and end_time are, and with them every time in between. The callback gets start_time. */
+  TransformableRequestHandle addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame,
+                                                     ros::Time start_time, ros::Time end_time,
+                                                     const ros::WallDuration& timeout = ros::WallDuration());
   /// \brief Internal use only
   void cancelTransformableRequest(TransformableRequestHandle handle);
 
@@ -243,6 +459,24 @@ public:
   void setUsingDedicatedThread(bool value) { using_dedicated_thread_ = value;};
   // Get the state of using_dedicated_thread_
   bool isUsingDedicatedThread() const { return using_dedicated_thread_;};
+
+  // Store the history of dynamic frames in single precision, see tf2::CompactTimeCache.
+  // Halves the cache memory, and only applies to frames which receive their first transform afterwards.
+  void setCompactStorage(bool value) { compact_storage_ = value;};
+  // Get the state of compact_storage_
+  bool isCompactStorage() const { return compact_storage_;};
+
+  /** \brief Evaluate large sets of pending transformable requests on worker threads
+   * When new data makes many requests (e.g. of a tf2_ros::MessageFilter) testable at once, they are
+   * checked in parallel and their callbacks are dispatched in parallel, so the callbacks registered
+   * with addTransformableCallback must be thread safe. Sets smaller than min_batch_size keep being
+   * handled serially on the thread which inserted the data.
+   * \param num_threads Number of worker threads in addition to the inserting thread, 0 (the default) disables them
+   * \param min_batch_size Smallest number of requests, or of callbacks, which is worth spreading over the workers
+   */
+  void setTransformableRequestWorkers(unsigned int num_threads, size_t min_batch_size = 256);
+  // Get the number of worker threads set with setTransformableRequestWorkers
+  unsigned int getTransformableRequestWorkers() const;
   
 
 
@@ -283,7 +517,7 @@ public:
   }
 
   int _getLatestCommonTime(CompactFrameID target_frame, CompactFrameID source_frame, ros::Time& time, std::string* error_string) const {
-    boost::mutex::scoped_lock lock(frame_mutex_);
+    boost::timed_mutex::scoped_lock lock(frame_mutex_);
     return getLatestCommonTime(target_frame, source_frame, time, error_string);
   }
 
@@ -294,6 +528,10 @@ public:
   /**@brief Get the duration over which this transformer will cache */
   ros::Duration getCacheLength() { return cache_time_;}
 
+  /**@brief Change the duration over which this transformer will cache, for new and existing frames
+   * A shorter duration takes effect for a frame with its next transform. */
+  void setCacheLength(const ros::Duration& cache_time);
+
   /** \brief Backwards compatabilityA way to see what frames have been cached
    * Useful for debugging
    */
@@ -305,6 +543,9 @@ public:
    */
   void _chainAsVector(const std::string & target_frame, ros::Time target_time, const std::string & source_frame, ros::Time source_time, const std::string & fixed_frame, std::vector<std::string>& output) const;
 
+  /**@brief Same as _chainAsVector above, but uses the containers of context as scratch space */
+  void _chainAsVector(const std::string & target_frame, ros::Time target_time, const std::string & source_frame, ros::Time source_time, const std::string & fixed_frame, std::vector<std::string>& output, LookupContext& context) const;
+
 private:
 
   /** \brief A way to see what frames have been cached
@@ -320,14 +561,13 @@ private:
   typedef std::vector<TimeCacheInterfacePtr> V_TimeCacheInterface;
   V_TimeCacheInterface frames_;
   
-  /** \brief A mutex to protect testing and allocating new frames on the above vector. */
-  mutable boost::mutex frame_mutex_;
-
-  /** \brief A map from string frame ids to CompactFrameID */
-  typedef boost::unordered_map<std::string, CompactFrameID> M_StringToCompactFrameID;
-  M_StringToCompactFrameID frameIDs_;
-  /** \brief A map from CompactFrameID frame_id_numbers to string for debugging and output */
-  std::vector<std::string> frameIDs_reverse;
+  /** \brief A mutex to protect testing and allocating new frames on the above vector.
+   * frames_ may be shorter than frame_registry_, ids past its end have no cache yet. */
+  mutable boost::timed_mutex frame_mutex_;
+
+  /** \brief The mapping between string frame ids and CompactFrameID.
+   * It has its own synchronization, so names are resolved without holding frame_mutex_. */
+  FrameRegistry frame_registry_;
   /** \brief A map to lookup the most recent authority for a given frame */
   std::map<CompactFrameID, std::string> frame_authority_;
 
@@ -335,6 +575,20 @@ private:
   /// How long to cache transform history
   ros::Duration cache_time_;
 
+  /** \brief Rejected insertions for one frame and authority since the last warning about them */
+  struct RejectedDataCounter
+  {
+    RejectedDataCounter() : count(0), total(0), reported(0) {}
+    ros::WallTime last_report;
+    /// Since the last warning
+    uint32_t count;
+    uint32_t total;
+    uint32_t reported;
+  };
+  typedef std::map<std::string, RejectedDataCounter> M_RejectedDataCounter;
+  /** \brief A map to rate limit the warnings about rejected data per frame and authority */
+  std::map<CompactFrameID, M_RejectedDataCounter> rejected_data_;
+
   typedef boost::unordered_map<TransformableCallbackHandle, TransformableCallback> M_TransformableCallback;
   M_TransformableCallback transformable_callbacks_;
   uint32_t transformable_callbacks_counter_;
@@ -343,6 +597,8 @@ private:
   struct TransformableRequest
   {
     ros::Time time;
+    /// End of the interval [time, end_time] which has to be transformable, equal to time for a single time
+    ros::Time end_time;
     TransformableRequestHandle request_handle;
     TransformableCallbackHandle cb_handle;
     CompactFrameID target_id;
@@ -352,11 +608,22 @@ private:
   };
   typedef std::vector<TransformableRequest> V_TransformableRequest;
   V_TransformableRequest transformable_requests_;
-  boost::mutex transformable_requests_mutex_;
+  mutable boost::mutex transformable_requests_mutex_;
   uint64_t transformable_requests_counter_;
+  /// Workers for large sets of requests, NULL unless enabled. Protected by transformable_requests_mutex_
+  boost::shared_ptr<WorkerPool> transformable_requests_pool_;
+  size_t transformable_requests_min_batch_;
+
+  /// Timeouts of requests, created with the first request with a timeout. Protected by transformable_requests_mutex_
+  boost::scoped_ptr<TimerWheel> transformable_requests_timers_;
+  /// Fails requests whose timeout passed, runs while transformable_requests_timers_ exists
+  boost::thread timeout_thread_;
+  boost::condition_variable timeout_condition_;
+  bool timeout_thread_shutdown_;
 
   struct RemoveRequestByCallback;
   struct RemoveRequestByID;
+  struct TransformableDispatch;
 
   // Backwards compatability for tf message_filter
   typedef boost::signals2::signal<void(void)> TransformsChangedSignal;
@@ -376,6 +643,15 @@ private:
 
   TimeCacheInterfacePtr allocateFrame(CompactFrameID cfid, bool is_static);
 
+  /** \brief Validate and insert count transforms, see setTransforms */
+  bool setTransformsImpl(const geometry_msgs::TransformStamped* transforms, size_t count, const std::string& authority, bool is_static);
+
+
+  /** \brief Count a rejected insertion and decide if it should be reported
+   * \param suppressed Filled with the number of rejections which were not reported since the last report
+   * \return True if a warning should be emitted for this rejection
+   */
+  bool countRejectedData(CompactFrameID frame_number, const std::string& authority, uint32_t& suppressed);
 
   bool warnFrameId(const char* function_name_arg, const std::string& frame_id) const;
   CompactFrameID validateFrameId(const char* function_name_arg, const std::string& frame_id) const;
@@ -390,10 +666,24 @@ private:
   const std::string& lookupFrameString(CompactFrameID frame_id_num) const;
 
   void createConnectivityErrorString(CompactFrameID source_frame, CompactFrameID target_frame, std::string* out) const;
+  void createLoopErrorString(CompactFrameID frame, std::string* out) const;
+
+  /** \brief Whether parent becoming the parent of child at stamp closes a loop through the latest parents of the
+   * frames, must be called with frame_mutex_ held. child_cache is NULL for a frame without data yet.
+   * Samples older than the newest one of child are never rejected. The walk uses the latest parent of each
+   * ancestor whatever its stamp, so a re-parent is still rejected when the data moving the ancestors out of the
+   * way arrives in a later setTransform call; within one call the rest of the batch is inserted first. */
+  bool closesLoopNoLock(const TimeCacheInterfacePtr& child_cache, CompactFrameID child, CompactFrameID parent,
+                        const ros::Time& stamp) const;
+  /** \brief Number of hops after which a walk up the tree has to be in a loop, must be called with frame_mutex_ held
+   * setTransform rejects loops, but parents vary over time, so walks stay bounded by the number of frames. */
+  uint32_t maxGraphDepthNoLock() const { return std::min<uint32_t>(MAX_GRAPH_DEPTH, frames_.size()); }
 
   /**@brief Return the latest rostime which is common across the spanning set
    * zero if fails to cross */
   int getLatestCommonTime(CompactFrameID target_frame, CompactFrameID source_frame, ros::Time& time, std::string* error_string) const;
+  int getLatestCommonTime(CompactFrameID target_frame, CompactFrameID source_frame, ros::Time& time, std::string* error_string,
+                          std::vector<P_TimeAndFrameID>& lct_cache) const;
 
   template<typename F>
   int walkToTopParent(F& f, ros::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string) const;
@@ -403,7 +693,41 @@ private:
   template<typename F>
   int walkToTopParent(F& f, ros::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID> *frame_chain) const;
 
+  /**@brief Traverse the transform tree, taking scratch space from context if it is not NULL. */
+  template<typename F>
+  int walkToTopParent(F& f, ros::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID> *frame_chain,
+                      LookupContext* context) const;
+
+  /** \brief The identity transform of frame at time, which like lookupTransform takes the latest
+   * time of the frame for time 0, must be called with frame_mutex_ held */
+  void identityTransformNoLock(const std::string& frame, const ros::Time& time,
+                               geometry_msgs::TransformStamped& transform) const;
+
+  /** \brief Answer one lookup of a batch, must be called with frame_mutex_ held
+   * time is replaced by the time the transform was found at, as lookupTransform does for time 0. */
+  int lookupBatchedNoLock(LookupBatch& batch, CompactFrameID target_id, CompactFrameID source_id, ros::Time& time,
+                          tf2::Quaternion& rotation, tf2::Vector3& translation, std::string& error_string) const;
+  /** \brief Transform from frame to the top of what can be walked at time, memoized in batch */
+  const LookupBatch::PathToTop& batchPathToTop(LookupBatch& batch, CompactFrameID frame, ros::Time time) const;
+
   void testTransformableRequests();
+  /** \brief Queue the callback of a request which is done, must be called with transformable_callbacks_mutex_ held
+   * req has to stay alive until the callback was called. */
+  void addTransformableDispatch(const TransformableRequest& req, TransformableResult result,
+                                std::vector<TransformableDispatch>& transformables) const;
+  static void callTransformables(const std::vector<TransformableDispatch>* transformables, size_t begin, size_t end);
+  /** \brief Call the callbacks of finished requests, on pool if it is set and the set is larger than min_batch */
+  void dispatchTransformables(const std::vector<TransformableDispatch>& transformables,
+                              const boost::shared_ptr<WorkerPool>& pool, size_t min_batch);
+  /** \brief Fail the pending requests whose timeout passed */
+  void expireTransformableRequests();
+  void timeoutThread();
+  /** \brief Check whether a pending request can be answered, must be called with frame_mutex_ held
+   * \return True if the request is done, with its outcome in result */
+  bool testTransformableRequestNoLock(TransformableRequest& req, TransformableResult& result,
+                                      std::vector<P_TimeAndFrameID>& lct_cache) const;
+  /** \brief Test requests [begin, end) on a worker, frame_mutex_ and transformable_requests_mutex_ are held by the caller */
+  void testTransformableRequestRange(size_t begin, size_t end, std::vector<uint8_t>& outcomes);
   bool canTransformInternal(CompactFrameID target_id, CompactFrameID source_id,
                     const ros::Time& time, std::string* error_msg) const;
   bool canTransformNoLock(CompactFrameID target_id, CompactFrameID source_id,
@@ -413,6 +737,9 @@ private:
   //Whether it is safe to use canTransform with a timeout. (If another thread is not provided it will always timeout.)
   bool using_dedicated_thread_;
 
+  //Whether new dynamic frames are allocated as CompactTimeCache
+  bool compact_storage_;
+
 public:
   friend class TestBufferCore; // For unit testing
 
@@ -427,6 +754,10 @@ public:
   {
     return buffer.lookupFrameString(frame_id_num);
   }
+  boost::timed_mutex& _frameMutex(BufferCore& buffer) const
+  {
+    return buffer.frame_mutex_;
+  }
 };
 }
 
@@ -0,0 +1,127 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef TF2_FRAME_REGISTRY_H
+#define TF2_FRAME_REGISTRY_H
+
+#include "transform_storage.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+namespace tf2
+{
+
+/** \brief Append only mapping between frame names and CompactFrameIDs.
+ *
+ * Ids are handed out densely from 0 in insertion order and a name is never removed, so readers
+ * resolve names and ids without taking a lock. Writers serialize on an internal mutex, store the
+ * new name where it will never move, fill its slot in the open addressing hash table used by find,
+ * and finally publish it by bumping size with a release store. Readers ignore ids at or past size,
+ * so a name becomes visible in both directions at once. A table which runs over half full is
+ * replaced by a copy of twice the size; replaced tables are kept until the registry is destroyed,
+ * since readers may still be probing them.
+ */
+class FrameRegistry
+{
+public:
+  FrameRegistry();
+  ~FrameRegistry();
+
+  /** \brief Id of a name, or 0 if it was never inserted. Lock free. */
+  CompactFrameID lookup(const std::string& name) const
+  {
+    CompactFrameID id = 0;
+    find(name, id);
+    return id;
+  }
+
+  /** \brief Fill id and return true if the name was inserted before. Lock free. */
+  bool find(const std::string& name, CompactFrameID& id) const;
+
+  /** \brief Id of a name, inserting it with the next free id if needed */
+  CompactFrameID lookupOrInsert(const std::string& name);
+
+  /** \brief Name of an id, or NULL if the id was not handed out. Lock free.
+   * The returned string stays valid for the lifetime of the registry. */
+  const std::string* lookupString(CompactFrameID id) const;
+
+  /** \brief Number of ids handed out so far. Lock free. */
+  CompactFrameID size() const { return size_.load(std::memory_order_acquire); }
+
+private:
+  struct Entry
+  {
+    std::string name;
+    std::size_t hash;
+  };
+
+  struct Table
+  {
+    explicit Table(std::size_t capacity);
+
+    std::size_t mask;
+    /// Id + 1 of the entry in each slot, 0 if the slot is empty
+    std::vector<std::atomic<uint32_t> > slots;
+  };
+
+  /** Entries live in segments of doubling size which are never moved or freed while the registry is
+   * alive. Segment k holds ids [FIRST_SEGMENT_SIZE * (2^k - 1), FIRST_SEGMENT_SIZE * (2^(k+1) - 1)). */
+  static const std::size_t FIRST_SEGMENT_SIZE = 32;
+  static const std::size_t MAX_SEGMENTS = 27;
+
+  static void locate(CompactFrameID id, std::size_t& segment, std::size_t& offset);
+  const Entry& entry(CompactFrameID id) const;
+
+  /** \brief Put an already published id into table, which must have a free slot */
+  static void insertSlot(Table& table, std::size_t hash, CompactFrameID id);
+
+  Entry* segments_[MAX_SEGMENTS];
+  std::atomic<CompactFrameID> size_;
+  std::atomic<Table*> table_;
+  std::vector<Table*> retired_tables_;
+  boost::mutex write_mutex_;
+
+  // Not copyable
+  FrameRegistry(const FrameRegistry&);
+  FrameRegistry& operator=(const FrameRegistry&);
+};
+
+}
+
+#endif // TF2_FRAME_REGISTRY_H
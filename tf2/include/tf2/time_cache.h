@@ -35,6 +35,7 @@
 #include "transform_storage.h"
 
 #include <deque>
+#include <vector>
 
 #include <ros/message_forward.h>
 #include <ros/time.h>
@@ -63,6 +64,17 @@ public:
   /** @brief Clear the list of stored values */
   virtual void clearList()=0;
 
+  /** @brief Remove all stored values with a timestamp later than time
+   * The default clears the whole list, caches which can keep the older values override it */
+  virtual void clearAfter(ros::Time time) { clearList(); }
+
+  /** @brief Change how long a history is kept, data beyond it is pruned with the next insertion */
+  virtual void setMaxStorageTime(ros::Duration max_storage_time) {}
+
+  /** @brief Append the stored values with a timestamp of at least start to data_out, oldest first
+   * The default appends nothing, so the history of a cache which does not override it is not shared */
+  virtual void getDataSince(ros::Time start, std::vector<TransformStorage>& data_out) {}
+
   /** \brief Retrieve the parent at a specific time */
   virtual CompactFrameID getParent(ros::Time time, std::string* error_str) = 0;
 
@@ -85,25 +97,25 @@ public:
 
 typedef boost::shared_ptr<TimeCacheInterface> TimeCacheInterfacePtr;
 
-/** \brief A class to keep a sorted linked list in time
- * This builds and maintains a list of timestamped
- * data.  And provides lookup functions to get
- * data out as a function of time. */
-class TimeCache : public TimeCacheInterface
+/** \brief The sorted history shared by TimeCache and CompactTimeCache
+ * StorageT is the type a sample is kept as. It has the stamp_ and frame_id_ members of
+ * TransformStorage, is constructed from a TransformStorage on insertion and widened back
+ * into one on lookup. The members are defined in cache.cpp for the two storage types.
+ */
+template <typename StorageT>
+class TimeCacheBase : public TimeCacheInterface
 {
  public:
-  static const int MIN_INTERPOLATION_DISTANCE = 5; //!< Number of nano-seconds to not interpolate below.
-  static const unsigned int MAX_LENGTH_LINKED_LIST = 1000000; //!< Maximum length of linked list, to make sure not to be able to use unlimited memory.
-  static const int64_t DEFAULT_MAX_STORAGE_TIME = 10ULL * 1000000000LL; //!< default value of 10 seconds storage
-
-  TimeCache(ros::Duration  max_storage_time = ros::Duration().fromNSec(DEFAULT_MAX_STORAGE_TIME));
-
+  TimeCacheBase(ros::Duration max_storage_time);
 
   /// Virtual methods
 
   virtual bool getData(ros::Time time, TransformStorage & data_out, std::string* error_str = 0);
   virtual bool insertData(const TransformStorage& new_data, std::string* error_str = 0);
   virtual void clearList();
+  virtual void clearAfter(ros::Time time);
+  virtual void getDataSince(ros::Time start, std::vector<TransformStorage>& data_out);
+  virtual void setMaxStorageTime(ros::Duration max_storage_time);
   virtual CompactFrameID getParent(ros::Time time, std::string* error_str);
   virtual P_TimeAndFrameID getLatestTimeAndParent();
 
@@ -111,10 +123,9 @@ class TimeCache : public TimeCacheInterface
   virtual unsigned int getListLength();
   virtual ros::Time getLatestTimestamp();
   virtual ros::Time getOldestTimestamp();
-  
 
-private:
-  typedef std::deque<TransformStorage> L_TransformStorage;
+protected:
+  typedef std::deque<StorageT> L_TransformStorage;
   L_TransformStorage storage_;
 
   ros::Duration max_storage_time_;
@@ -122,25 +133,47 @@ private:
 
   /// A helper function for getData
   //Assumes storage is already locked for it
-  inline uint8_t findClosest(TransformStorage*& one, TransformStorage*& two, ros::Time target_time, std::string* error_str);
-
-  inline void interpolate(const TransformStorage& one, const TransformStorage& two, ros::Time time, TransformStorage& output);
-
+  uint8_t findClosest(StorageT*& one, StorageT*& two, ros::Time target_time, std::string* error_str);
 
   void pruneList();
+};
 
+/** \brief A class to keep a sorted linked list in time
+ * This builds and maintains a list of timestamped
+ * data.  And provides lookup functions to get
+ * data out as a function of time. */
+class TimeCache : public TimeCacheBase<TransformStorage>
+{
+ public:
+  static const int MIN_INTERPOLATION_DISTANCE = 5; //!< Number of nano-seconds to not interpolate below.
+  static const unsigned int MAX_LENGTH_LINKED_LIST = 1000000; //!< Maximum length of linked list, to make sure not to be able to use unlimited memory.
+  static const int64_t DEFAULT_MAX_STORAGE_TIME = 10ULL * 1000000000LL; //!< default value of 10 seconds storage
 
+  TimeCache(ros::Duration  max_storage_time = ros::Duration().fromNSec(DEFAULT_MAX_STORAGE_TIME));
+};
 
+/** \brief A TimeCache which stores its samples in single precision
+ * Halves the memory and bandwidth of the cache at the cost of the precision documented
+ * for CompactTransformStorage. Lookups return double precision data and interpolate in double.
+ */
+class CompactTimeCache : public TimeCacheBase<CompactTransformStorage>
+{
+ public:
+  CompactTimeCache(ros::Duration  max_storage_time = ros::Duration().fromNSec(TimeCache::DEFAULT_MAX_STORAGE_TIME));
 };
 
 class StaticCache : public TimeCacheInterface
 {
  public:
+  StaticCache();
+
   /// Virtual methods
 
   virtual bool getData(ros::Time time, TransformStorage & data_out, std::string* error_str = 0); //returns false if data unavailable (should be thrown as lookup exception
   virtual bool insertData(const TransformStorage& new_data, std::string* error_str = 0);
   virtual void clearList();
+  virtual void clearAfter(ros::Time time);
+  virtual void getDataSince(ros::Time start, std::vector<TransformStorage>& data_out);
   virtual CompactFrameID getParent(ros::Time time, std::string* error_str);
   virtual P_TimeAndFrameID getLatestTimeAndParent();
 
@@ -80,6 +80,48 @@ public:
   CompactFrameID child_frame_id_;
 };
 
+/** \brief Single precision storage for transforms and their parent, used by CompactTimeCache
+ * Takes 44 instead of 80 bytes per sample. Values are rounded to float when stored and widened back
+ * to double when read, so interpolation and composition still happen in double precision.
+ * A float carries a 24 bit mantissa: translations within 4 km are kept to better than 0.25 mm
+ * (0.06 mm within 1 km), and rotations to better than 1e-7 rad.
+ */
+class CompactTransformStorage
+{
+public:
+  CompactTransformStorage() {}
+  explicit CompactTransformStorage(const TransformStorage& data)
+  : stamp_(data.stamp_)
+  , frame_id_(data.frame_id_)
+  , child_frame_id_(data.child_frame_id_)
+  {
+    rotation_[0] = data.rotation_.x();
+    rotation_[1] = data.rotation_.y();
+    rotation_[2] = data.rotation_.z();
+    rotation_[3] = data.rotation_.w();
+    translation_[0] = data.translation_.x();
+    translation_[1] = data.translation_.y();
+    translation_[2] = data.translation_.z();
+  }
+
+  /** \brief Widen the stored values back into double precision storage */
+  void toTransformStorage(TransformStorage& out) const
+  {
+    // renormalize to remove the rounding error from the quaternion norm
+    out.rotation_ = tf2::Quaternion(rotation_[0], rotation_[1], rotation_[2], rotation_[3]).normalized();
+    out.translation_ = tf2::Vector3(translation_[0], translation_[1], translation_[2]);
+    out.stamp_ = stamp_;
+    out.frame_id_ = frame_id_;
+    out.child_frame_id_ = child_frame_id_;
+  }
+
+  float rotation_[4];
+  float translation_[3];
+  ros::Time stamp_;
+  CompactFrameID frame_id_;
+  CompactFrameID child_frame_id_;
+};
+
 }
 
 #endif // TF2_TRANSFORM_STORAGE_H
@@ -37,6 +37,9 @@
 #include <assert.h>
 #include <console_bridge/console.h>
 #include "tf2/LinearMath/Transform.h"
+#include "timer_wheel.h"
+#include "worker_pool.h"
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
 namespace tf2
@@ -45,6 +48,12 @@ namespace tf2
 // Tolerance for acceptable quaternion normalization
 static double QUATERNION_NORMALIZATION_TOLERANCE = 10e-3;
 
+// Minimum time between warnings about rejected data for the same frame and authority
+static double REJECTED_DATA_REPORT_PERIOD = 5.0;
+
+// Callers compare results against it, which needs a definition
+const int BufferCore::LOOKUP_BUSY;
+
 /** \brief convert Transform msg to Transform */
 void transformMsgToTF2(const geometry_msgs::Transform& msg, tf2::Transform& tf2)
 {tf2 = tf2::Transform(tf2::Quaternion(msg.rotation.x, msg.rotation.y, msg.rotation.z, msg.rotation.w), tf2::Vector3(msg.translation.x, msg.translation.y, msg.translation.z));}
@@ -169,16 +178,24 @@ BufferCore::BufferCore(ros::Duration cache_time)
 : cache_time_(cache_time)
 , transformable_callbacks_counter_(0)
 , transformable_requests_counter_(0)
+, transformable_requests_min_batch_(256)
+, timeout_thread_shutdown_(false)
 , using_dedicated_thread_(false)
+, compact_storage_(false)
 {
-  frameIDs_["NO_PARENT"] = 0;
+  frame_registry_.lookupOrInsert("NO_PARENT");
   frames_.push_back(TimeCacheInterfacePtr());
-  frameIDs_reverse.push_back("NO_PARENT");
 }
 
 BufferCore::~BufferCore()
 {
-
+  {
+    boost::mutex::scoped_lock lock(transformable_requests_mutex_);
+    timeout_thread_shutdown_ = true;
+  }
+  timeout_condition_.notify_all();
+  if (timeout_thread_.joinable())
+    timeout_thread_.join();
 }
 
 void BufferCore::clear()
@@ -186,7 +203,7 @@ void BufferCore::clear()
   //old_tf_.clear();
 
 
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   if ( frames_.size() > 1 )
   {
     for (std::vector<TimeCacheInterfacePtr>::iterator  cache_it = frames_.begin() + 1; cache_it != frames_.end(); ++cache_it)
@@ -195,7 +212,35 @@ void BufferCore::clear()
         (*cache_it)->clearList();
     }
   }
-  
+  rejected_data_.clear();
+}
+
+void BufferCore::setCacheLength(const ros::Duration& cache_time)
+{
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
+  cache_time_ = cache_time;
+  for (size_t i = 1; i < frames_.size(); ++i)
+  {
+    if (frames_[i])
+      frames_[i]->setMaxStorageTime(cache_time);
+  }
+}
+
+void BufferCore::clearAfter(const ros::Time& time)
+{
+  {
+    boost::timed_mutex::scoped_lock lock(frame_mutex_);
+    if ( frames_.size() > 1 )
+    {
+      for (std::vector<TimeCacheInterfacePtr>::iterator  cache_it = frames_.begin() + 1; cache_it != frames_.end(); ++cache_it)
+      {
+        if (*cache_it)
+          (*cache_it)->clearAfter(time);
+      }
+    }
+  }
+
+  testTransformableRequests();
 }
 
 bool BufferCore::setTransform(const geometry_msgs::TransformStamped& transform_in, const std::string& authority, bool is_static)
@@ -209,87 +254,377 @@ bool BufferCore::setTransform(const geometry_msgs::TransformStamped& transform_i
     printf("Warning old setTransform Failed but was not caught\n");
     }*/
 
-  /////// New implementation
-  geometry_msgs::TransformStamped stripped = transform_in;
-  stripped.header.frame_id = stripSlash(stripped.header.frame_id);
-  stripped.child_frame_id = stripSlash(stripped.child_frame_id);
+  return setTransformsImpl(&transform_in, 1, authority, is_static);
+}
+
+bool BufferCore::setTransforms(const std::vector<geometry_msgs::TransformStamped>& transforms, const std::string& authority, bool is_static)
+{
+  if (transforms.empty())
+    return true;
 
+  return setTransformsImpl(&transforms[0], transforms.size(), authority, is_static);
+}
 
-  bool error_exists = false;
+void BufferCore::getFrameHistory(const std::vector<std::string>& frames, const ros::Duration& history,
+                                 std::vector<tf2_msgs::FrameHistory>& frame_history) const
+{
+  frame_history.clear();
+
+  std::vector<CompactFrameID> frame_ids;
+  frame_ids.reserve(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i)
+  {
+    CompactFrameID frame_id = lookupFrameNumber(stripSlash(frames[i]));
+    if (frame_id != 0)
+      frame_ids.push_back(frame_id);
+  }
+
+  std::vector<TransformStorage> samples;
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
+  if (frames.empty())
+  {
+    for (CompactFrameID frame_id = 1; frame_id < frames_.size(); ++frame_id)//one referenced for 0 is no frame
+      frame_ids.push_back(frame_id);
+  }
+
+  for (size_t i = 0; i < frame_ids.size(); ++i)
+  {
+    TimeCacheInterfacePtr cache = getFrame(frame_ids[i]);
+    if (!cache)
+      continue;
+
+    ros::Time start;
+    ros::Time latest = cache->getLatestTimestamp();
+    if (!history.isZero() && latest > ros::Time() + history)
+      start = latest - history;
+    samples.clear();
+    cache->getDataSince(start, samples);
+    if (samples.empty())
+      continue;
+
+    frame_history.push_back(tf2_msgs::FrameHistory());
+    tf2_msgs::FrameHistory& out = frame_history.back();
+    out.child_frame_id = lookupFrameString(frame_ids[i]);
+    out.is_static = (dynamic_cast<StaticCache*>(cache.get()) != NULL);
+    out.parents.resize(samples.size());
+    out.stamps.resize(samples.size());
+    out.transforms.resize(samples.size());
+
+    std::vector<CompactFrameID> parent_ids;
+    for (size_t j = 0; j < samples.size(); ++j)
+    {
+      const TransformStorage& sample = samples[j];
+      // Parents rarely change, so searching the few seen so far is cheap
+      size_t parent = std::find(parent_ids.begin(), parent_ids.end(), sample.frame_id_) - parent_ids.begin();
+      if (parent == parent_ids.size())
+      {
+        parent_ids.push_back(sample.frame_id_);
+        out.parent_frame_ids.push_back(lookupFrameString(sample.frame_id_));
+      }
+      out.parents[j] = parent;
+      out.stamps[j] = sample.stamp_;
+      transformTF2ToMsg(sample.rotation_, sample.translation_, out.transforms[j]);
+    }
+  }
+}
+
+bool BufferCore::setFrameHistory(const std::vector<tf2_msgs::FrameHistory>& frame_history, const std::string& authority)
+{
+  std::vector<geometry_msgs::TransformStamped> transforms, static_transforms;
+  bool ok = true;
+  for (size_t i = 0; i < frame_history.size(); ++i)
+  {
+    const tf2_msgs::FrameHistory& history = frame_history[i];
+    if (history.parents.size() != history.stamps.size() || history.transforms.size() != history.stamps.size())
+    {
+      CONSOLE_BRIDGE_logError("Ignoring the history of frame \"%s\" from authority \"%s\", it has %u stamps but %u parents and %u transforms",
+                              history.child_frame_id.c_str(), authority.c_str(), (unsigned int)history.stamps.size(),
+                              (unsigned int)history.parents.size(), (unsigned int)history.transforms.size());
+      ok = false;
+      continue;
+    }
+
+    // The history only fills in the past. Samples from the oldest one this buffer already has on were
+    // usually received live as well and would be rejected as repeated data.
+    ros::Time oldest;
+    CompactFrameID frame_id = history.is_static ? 0 : lookupFrameNumber(stripSlash(history.child_frame_id));
+    if (frame_id != 0)
+    {
+      boost::timed_mutex::scoped_lock lock(frame_mutex_);
+      TimeCacheInterfacePtr cache = getFrame(frame_id);
+      if (cache)
+        oldest = cache->getOldestTimestamp();
+    }
+
+    std::vector<geometry_msgs::TransformStamped>& out = history.is_static ? static_transforms : transforms;
+    for (size_t j = 0; j < history.stamps.size(); ++j)
+    {
+      if (history.parents[j] >= history.parent_frame_ids.size())
+      {
+        CONSOLE_BRIDGE_logError("Ignoring a sample of frame \"%s\" from authority \"%s\", its parent index %u is out of range",
+                                history.child_frame_id.c_str(), authority.c_str(), history.parents[j]);
+        ok = false;
+        continue;
+      }
+      if (!oldest.isZero() && history.stamps[j] >= oldest)
+        continue;
+      out.push_back(geometry_msgs::TransformStamped());
+      geometry_msgs::TransformStamped& transform = out.back();
+      transform.header.stamp = history.stamps[j];
+      transform.header.frame_id = history.parent_frame_ids[history.parents[j]];
+      transform.child_frame_id = history.child_frame_id;
+      transform.transform = history.transforms[j];
+    }
+  }
+
+  if (!setTransforms(static_transforms, authority, true))
+    ok = false;
+  if (!setTransforms(transforms, authority, false))
+    ok = false;
+  return ok;
+}
+
+/** \brief Check that all seven values of a transform are finite and that its rotation is normalized.
+ * Multiplying by zero turns any inf or nan into nan, so a single comparison covers all values,
+ * and the squared norm is computed once for both the finite and the normalization test.
+ */
+static inline bool isValidTransformValues(const geometry_msgs::Transform& t)
+{
+  const double norm = t.rotation.x * t.rotation.x + t.rotation.y * t.rotation.y
+                    + t.rotation.z * t.rotation.z + t.rotation.w * t.rotation.w;
+  const double zero = (t.translation.x + t.translation.y + t.translation.z + norm) * 0.0;
+  return zero == 0.0 && std::abs(norm - 1.0) < QUATERNION_NORMALIZATION_TOLERANCE;
+}
+
+/** \brief Fast check of everything setTransform requires from its input, see reportInvalidTransform */
+static inline bool isValidTransform(const geometry_msgs::TransformStamped& transform)
+{
+  return !transform.child_frame_id.empty() && !transform.header.frame_id.empty() &&
+         transform.child_frame_id != transform.header.frame_id &&
+         isValidTransformValues(transform.transform);
+}
+
+/** \brief Log why a transform failed isValidTransform. Only called on the failure path. */
+static void reportInvalidTransform(const geometry_msgs::TransformStamped& stripped, const std::string& authority)
+{
   if (stripped.child_frame_id == stripped.header.frame_id)
   {
     CONSOLE_BRIDGE_logError("TF_SELF_TRANSFORM: Ignoring transform from authority \"%s\" with frame_id and child_frame_id  \"%s\" because they are the same",  authority.c_str(), stripped.child_frame_id.c_str());
-    error_exists = true;
   }
 
   if (stripped.child_frame_id == "")
   {
     CONSOLE_BRIDGE_logError("TF_NO_CHILD_FRAME_ID: Ignoring transform from authority \"%s\" because child_frame_id not set ", authority.c_str());
-    error_exists = true;
   }
 
   if (stripped.header.frame_id == "")
   {
     CONSOLE_BRIDGE_logError("TF_NO_FRAME_ID: Ignoring transform with child_frame_id \"%s\"  from authority \"%s\" because frame_id not set", stripped.child_frame_id.c_str(), authority.c_str());
-    error_exists = true;
   }
 
-  if (std::isnan(stripped.transform.translation.x) || std::isnan(stripped.transform.translation.y) || std::isnan(stripped.transform.translation.z)||
-      std::isnan(stripped.transform.rotation.x) ||       std::isnan(stripped.transform.rotation.y) ||       std::isnan(stripped.transform.rotation.z) ||       std::isnan(stripped.transform.rotation.w))
+  if (!std::isfinite(stripped.transform.translation.x) || !std::isfinite(stripped.transform.translation.y) || !std::isfinite(stripped.transform.translation.z)||
+      !std::isfinite(stripped.transform.rotation.x) ||       !std::isfinite(stripped.transform.rotation.y) ||       !std::isfinite(stripped.transform.rotation.z) ||       !std::isfinite(stripped.transform.rotation.w))
   {
-    CONSOLE_BRIDGE_logError("TF_NAN_INPUT: Ignoring transform for child_frame_id \"%s\" from authority \"%s\" because of a nan value in the transform (%f %f %f) (%f %f %f %f)",
+    CONSOLE_BRIDGE_logError("TF_NAN_INPUT: Ignoring transform for child_frame_id \"%s\" from authority \"%s\" because of a nan or inf value in the transform (%f %f %f) (%f %f %f %f)",
               stripped.child_frame_id.c_str(), authority.c_str(),
               stripped.transform.translation.x, stripped.transform.translation.y, stripped.transform.translation.z,
               stripped.transform.rotation.x, stripped.transform.rotation.y, stripped.transform.rotation.z, stripped.transform.rotation.w
               );
-    error_exists = true;
   }
-
-  bool valid = std::abs((stripped.transform.rotation.w * stripped.transform.rotation.w
-                        + stripped.transform.rotation.x * stripped.transform.rotation.x
-                        + stripped.transform.rotation.y * stripped.transform.rotation.y
-                        + stripped.transform.rotation.z * stripped.transform.rotation.z) - 1.0f) < QUATERNION_NORMALIZATION_TOLERANCE;
-
-  if (!valid) 
+  else if (!isValidTransformValues(stripped.transform))
   {
     CONSOLE_BRIDGE_logError("TF_DENORMALIZED_QUATERNION: Ignoring transform for child_frame_id \"%s\" from authority \"%s\" because of an invalid quaternion in the transform (%f %f %f %f)",
              stripped.child_frame_id.c_str(), authority.c_str(),
              stripped.transform.rotation.x, stripped.transform.rotation.y, stripped.transform.rotation.z, stripped.transform.rotation.w);
-    error_exists = true;
   }
+}
 
-  if (error_exists)
-    return false;
-  
+/** \brief A rejected insertion which will be reported once the frame lock is released */
+struct RejectedDataReport
+{
+  std::string error_string;
+  std::string child_frame_id;
+  ros::Time stamp;
+  uint32_t suppressed;
+};
+
+bool BufferCore::setTransformsImpl(const geometry_msgs::TransformStamped* transforms, size_t count, const std::string& authority, bool is_static)
+{
+  bool error_exists = false;
+
+  // Validate the whole batch before taking the lock. Valid input is by far the common case, so it is
+  // checked with one fused test and only copied if a frame id needs its leading slash stripped.
+  std::vector<const geometry_msgs::TransformStamped*> valid_transforms;
+  valid_transforms.reserve(count);
+  std::vector<geometry_msgs::TransformStamped> stripped_transforms;
+  for (size_t i = 0; i < count; ++i)
   {
-    boost::mutex::scoped_lock lock(frame_mutex_);
-    CompactFrameID frame_number = lookupOrInsertFrameNumber(stripped.child_frame_id);
-    TimeCacheInterfacePtr frame = getFrame(frame_number);
-    if (frame == NULL)
-      frame = allocateFrame(frame_number, is_static);
+    const geometry_msgs::TransformStamped* transform = &transforms[i];
+    if (startsWithSlash(transform->header.frame_id) || startsWithSlash(transform->child_frame_id))
+    {
+      // reserve up front so pointers into stripped_transforms stay valid
+      if (stripped_transforms.empty())
+        stripped_transforms.reserve(count - i);
+      stripped_transforms.push_back(*transform);
+      geometry_msgs::TransformStamped& stripped = stripped_transforms.back();
+      stripped.header.frame_id = stripSlash(stripped.header.frame_id);
+      stripped.child_frame_id = stripSlash(stripped.child_frame_id);
+      transform = &stripped;
+    }
+
+    if (isValidTransform(*transform))
+    {
+      valid_transforms.push_back(transform);
+    }
+    else
+    {
+      reportInvalidTransform(*transform, authority);
+      error_exists = true;
+    }
+  }
+
+  if (valid_transforms.empty())
+    return !error_exists;
 
+  // Insert the whole batch under a single lock
+  bool inserted = false;
+  std::vector<RejectedDataReport> rejected;
+  {
+    boost::timed_mutex::scoped_lock lock(frame_mutex_);
     std::string error_string;
-    if (frame->insertData(TransformStorage(stripped, lookupOrInsertFrameNumber(stripped.header.frame_id), frame_number), &error_string))
+    // A sample may only close a loop until the rest of its batch has moved the other frames, e.g. two frames
+    // swapping places in one message, so those samples are retried as long as the retries make progress.
+    std::vector<const geometry_msgs::TransformStamped*> looping;
+    for (bool last_pass = false; !valid_transforms.empty(); valid_transforms.swap(looping))
+    {
+      looping.clear();
+      for (size_t i = 0; i < valid_transforms.size(); ++i)
+      {
+        const geometry_msgs::TransformStamped& stripped = *valid_transforms[i];
+        CompactFrameID frame_number = lookupOrInsertFrameNumber(stripped.child_frame_id);
+        TimeCacheInterfacePtr frame = getFrame(frame_number);
+        CompactFrameID parent_number = lookupOrInsertFrameNumber(stripped.header.frame_id);
+        bool accepted;
+        if (closesLoopNoLock(frame, frame_number, parent_number, stripped.header.stamp))
+        {
+          if (!last_pass)
+          {
+            looping.push_back(valid_transforms[i]);
+            continue;
+          }
+          error_string = "TF_LOOP: Ignoring data because its parent frame_id \"" + stripped.header.frame_id +
+                         "\" is a descendant of it, which would make the tree a loop";
+          accepted = false;
+        }
+        else
+        {
+          // Only allocated for accepted data, so a rejected first sample leaves no empty cache behind
+          if (frame == NULL)
+            frame = allocateFrame(frame_number, is_static);
+          accepted = frame->insertData(TransformStorage(stripped, parent_number, frame_number), &error_string);
+        }
+
+        if (accepted)
+        {
+          frame_authority_[frame_number] = authority;
+          inserted = true;
+        }
+        else
+        {
+          uint32_t suppressed = 0;
+          if (countRejectedData(frame_number, authority, suppressed))
+          {
+            RejectedDataReport report;
+            report.error_string = error_string;
+            report.child_frame_id = stripped.child_frame_id;
+            report.stamp = stripped.header.stamp;
+            report.suppressed = suppressed;
+            rejected.push_back(report);
+          }
+          error_exists = true;
+        }
+      }
+      // Reject whatever still closes a loop once a pass inserted nothing
+      last_pass = looping.size() == valid_transforms.size();
+    }
+  }
+
+  // Format the warnings after releasing the lock, and only once per report period
+  for (size_t i = 0; i < rejected.size(); ++i)
+  {
+    const RejectedDataReport& report = rejected[i];
+    if (report.suppressed == 0)
     {
-      frame_authority_[frame_number] = authority;
+      CONSOLE_BRIDGE_logWarn("%s for frame %s at time %lf according to authority %s",
+                             report.error_string.c_str(), report.child_frame_id.c_str(), report.stamp.toSec(), authority.c_str());
     }
     else
     {
-      CONSOLE_BRIDGE_logWarn((error_string+" for frame %s at time %lf according to authority %s").c_str(), stripped.child_frame_id.c_str(), stripped.header.stamp.toSec(), authority.c_str());
-      return false;
+      CONSOLE_BRIDGE_logWarn("%s for frame %s at time %lf according to authority %s (%u similar warnings suppressed)",
+                             report.error_string.c_str(), report.child_frame_id.c_str(), report.stamp.toSec(), authority.c_str(),
+                             report.suppressed);
     }
   }
 
-  testTransformableRequests();
+  if (inserted)
+    testTransformableRequests();
 
-  return true;
+  return !error_exists;
+}
+
+bool BufferCore::countRejectedData(CompactFrameID frame_number, const std::string& authority, uint32_t& suppressed)
+{
+  M_RejectedDataCounter& frame_counters = rejected_data_[frame_number];
+  M_RejectedDataCounter::iterator it = frame_counters.find(authority);
+  if (it == frame_counters.end())
+  {
+    it = frame_counters.insert(std::make_pair(authority, RejectedDataCounter())).first;
+  }
+
+  RejectedDataCounter& counter = it->second;
+  ++counter.total;
+  ros::WallTime now = ros::WallTime::now();
+  if (counter.last_report.isZero() || (now - counter.last_report).toSec() >= REJECTED_DATA_REPORT_PERIOD)
+  {
+    suppressed = counter.count;
+    counter.count = 0;
+    counter.last_report = now;
+    ++counter.reported;
+    return true;
+  }
+
+  ++counter.count;
+  return false;
+}
+
+void BufferCore::getRejectedDataCounts(std::vector<RejectedDataCount>& counts) const
+{
+  counts.clear();
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
+  for (std::map<CompactFrameID, M_RejectedDataCounter>::const_iterator frame_it = rejected_data_.begin();
+       frame_it != rejected_data_.end(); ++frame_it)
+  {
+    for (M_RejectedDataCounter::const_iterator it = frame_it->second.begin(); it != frame_it->second.end(); ++it)
+    {
+      RejectedDataCount count;
+      count.child_frame_id = lookupFrameString(frame_it->first);
+      count.authority = it->first;
+      count.rejected = it->second.total;
+      count.reported = it->second.reported;
+      counts.push_back(count);
+    }
+  }
 }
 
 TimeCacheInterfacePtr BufferCore::allocateFrame(CompactFrameID cfid, bool is_static)
 {
-  TimeCacheInterfacePtr frame_ptr = frames_[cfid];
+  if (cfid >= frames_.size())
+    frames_.resize(cfid + 1);
+
   if (is_static) {
     frames_[cfid] = TimeCacheInterfacePtr(new StaticCache());
+  } else if (compact_storage_) {
+    frames_[cfid] = TimeCacheInterfacePtr(new CompactTimeCache(cache_time_));
   } else {
     frames_[cfid] = TimeCacheInterfacePtr(new TimeCache(cache_time_));
   }
@@ -316,6 +651,14 @@ template<typename F>
 int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
     CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID>
     *frame_chain) const
+{
+  return walkToTopParent(f, time, target_id, source_id, error_string, frame_chain, NULL);
+}
+
+template<typename F>
+int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
+    CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID>
+    *frame_chain, LookupContext* context) const
 {
   if (frame_chain)
     frame_chain->clear();
@@ -330,7 +673,9 @@ int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
   //If getting the latest get the latest common time
   if (time == ros::Time())
   {
-    int retval = getLatestCommonTime(target_id, source_id, time, error_string);
+    std::vector<P_TimeAndFrameID> local_lct_cache;
+    int retval = getLatestCommonTime(target_id, source_id, time, error_string,
+                                     context ? context->lct_cache_ : local_lct_cache);
     if (retval != tf2_msgs::TF2Error::NO_ERROR)
     {
       return retval;
@@ -341,6 +686,7 @@ int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
   CompactFrameID frame = source_id;
   CompactFrameID top_parent = frame;
   uint32_t depth = 0;
+  const uint32_t max_depth = maxGraphDepthNoLock();
 
   std::string extrapolation_error_string;
   bool extrapolation_might_have_occurred = false;
@@ -380,15 +726,9 @@ int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
     frame = parent;
 
     ++depth;
-    if (depth > MAX_GRAPH_DEPTH)
+    if (depth > max_depth)
     {
-      if (error_string)
-      {
-        std::stringstream ss;
-        ss << "The tf tree is invalid because it contains a loop." << std::endl
-           << allFramesAsStringNoLock() << std::endl;
-        *error_string = ss.str();
-      }
+      createLoopErrorString(frame, error_string);
       return tf2_msgs::TF2Error::LOOKUP_ERROR;
     }
   }
@@ -396,7 +736,9 @@ int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
   // Now walk to the top parent from the target frame, accumulating its transform
   frame = target_id;
   depth = 0;
-  std::vector<CompactFrameID> reverse_frame_chain;
+  std::vector<CompactFrameID> local_reverse_frame_chain;
+  std::vector<CompactFrameID>& reverse_frame_chain = context ? context->reverse_frame_chain_ : local_reverse_frame_chain;
+  reverse_frame_chain.clear();
 
   while (frame != top_parent)
   {
@@ -442,15 +784,9 @@ int BufferCore::walkToTopParent(F& f, ros::Time time, CompactFrameID target_id,
     frame = parent;
 
     ++depth;
-    if (depth > MAX_GRAPH_DEPTH)
+    if (depth > max_depth)
     {
-      if (error_string)
-      {
-        std::stringstream ss;
-        ss << "The tf tree is invalid because it contains a loop." << std::endl
-           << allFramesAsStringNoLock() << std::endl;
-        *error_string = ss.str();
-      }
+      createLoopErrorString(frame, error_string);
       return tf2_msgs::TF2Error::LOOKUP_ERROR;
     }
   }
@@ -595,36 +931,36 @@ geometry_msgs::TransformStamped BufferCore::lookupTransform(const std::string& t
                                                             const std::string& source_frame,
                                                             const ros::Time& time) const
 {
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  LookupContext context;
+  geometry_msgs::TransformStamped output_transform;
+  lookupTransform(target_frame, source_frame, time, output_transform, context);
+  return output_transform;
+}
 
+void BufferCore::lookupTransform(const std::string& target_frame,
+                                 const std::string& source_frame,
+                                 const ros::Time& time,
+                                 geometry_msgs::TransformStamped& output_transform,
+                                 LookupContext& context) const
+{
   if (target_frame == source_frame) {
-    geometry_msgs::TransformStamped identity;
-    identity.header.frame_id = target_frame;
-    identity.child_frame_id = source_frame;
-    identity.transform.rotation.w = 1;
-
-    if (time == ros::Time())
-    {
-      CompactFrameID target_id = lookupFrameNumber(target_frame);
-      TimeCacheInterfacePtr cache = getFrame(target_id);
-      if (cache)
-        identity.header.stamp = cache->getLatestTimestamp();
-      else
-        identity.header.stamp = time;
-    }
-    else
-      identity.header.stamp = time;
-
-    return identity;
+    boost::timed_mutex::scoped_lock lock(frame_mutex_);
+    identityTransformNoLock(target_frame, time, output_transform);
+    return;
   }
 
   //Identify case does not need to be validated above
   CompactFrameID target_id = validateFrameId("lookupTransform argument target_frame", target_frame);
   CompactFrameID source_id = validateFrameId("lookupTransform argument source_frame", source_frame);
 
-  std::string error_string;
+  std::string& error_string = context.error_string_;
+  error_string.clear();
   TransformAccum accum;
-  int retval = walkToTopParent(accum, time, target_id, source_id, &error_string);
+  int retval;
+  {
+    boost::timed_mutex::scoped_lock lock(frame_mutex_);
+    retval = walkToTopParent(accum, time, target_id, source_id, &error_string, NULL, &context);
+  }
   if (retval != tf2_msgs::TF2Error::NO_ERROR)
   {
     switch (retval)
@@ -641,34 +977,344 @@ geometry_msgs::TransformStamped BufferCore::lookupTransform(const std::string& t
     }
   }
 
-  geometry_msgs::TransformStamped output_transform;
   transformTF2ToMsg(accum.result_quat, accum.result_vec, output_transform, accum.time, target_frame, source_frame);
-  return output_transform;
 }
 
-                                                       
-geometry_msgs::TransformStamped BufferCore::lookupTransform(const std::string& target_frame, 
-                                                        const ros::Time& target_time,
-                                                        const std::string& source_frame,
-                                                        const ros::Time& source_time,
-                                                        const std::string& fixed_frame) const
+int BufferCore::tryLookupTransform(const std::string& target_frame,
+                                   const std::string& source_frame,
+                                   const ros::Time& time,
+                                   const ros::WallDuration& max_wait,
+                                   geometry_msgs::TransformStamped& output_transform,
+                                   LookupContext& context) const
+{
+  std::string& error_string = context.error_string_;
+  error_string.clear();
+
+  // Resolving names does not take frame_mutex_, so this can not be held up by writers
+  CompactFrameID target_id = 0;
+  CompactFrameID source_id = 0;
+  if (target_frame != source_frame)
+  {
+    try
+    {
+      target_id = validateFrameId("tryLookupTransform argument target_frame", target_frame);
+      source_id = validateFrameId("tryLookupTransform argument source_frame", source_frame);
+    }
+    catch (const InvalidArgumentException& ex)
+    {
+      error_string = ex.what();
+      return tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR;
+    }
+    catch (const LookupException& ex)
+    {
+      error_string = ex.what();
+      return tf2_msgs::TF2Error::LOOKUP_ERROR;
+    }
+  }
+
+  boost::timed_mutex::scoped_lock lock(frame_mutex_, boost::defer_lock);
+  bool locked;
+  if (max_wait > ros::WallDuration())
+    locked = lock.timed_lock(boost::posix_time::microseconds(max_wait.toNSec() / 1000));
+  else
+    locked = lock.try_lock();
+  if (!locked)
+  {
+    error_string = "The buffer was busy";
+    return LOOKUP_BUSY;
+  }
+
+  if (target_frame == source_frame)
+  {
+    identityTransformNoLock(target_frame, time, output_transform);
+    return tf2_msgs::TF2Error::NO_ERROR;
+  }
+
+  TransformAccum accum;
+  int retval = walkToTopParent(accum, time, target_id, source_id, &error_string, NULL, &context);
+  lock.unlock();
+  if (retval == tf2_msgs::TF2Error::NO_ERROR)
+  {
+    transformTF2ToMsg(accum.result_quat, accum.result_vec, output_transform, accum.time, target_frame, source_frame);
+  }
+  return retval;
+}
+
+void BufferCore::identityTransformNoLock(const std::string& frame, const ros::Time& time,
+                                         geometry_msgs::TransformStamped& output_transform) const
+{
+  output_transform.header.frame_id = frame;
+  output_transform.child_frame_id = frame;
+  output_transform.transform.translation.x = 0;
+  output_transform.transform.translation.y = 0;
+  output_transform.transform.translation.z = 0;
+  output_transform.transform.rotation.x = 0;
+  output_transform.transform.rotation.y = 0;
+  output_transform.transform.rotation.z = 0;
+  output_transform.transform.rotation.w = 1;
+
+  if (time == ros::Time())
+  {
+    CompactFrameID frame_id = lookupFrameNumber(frame);
+    TimeCacheInterfacePtr cache = getFrame(frame_id);
+    if (cache)
+      output_transform.header.stamp = cache->getLatestTimestamp();
+    else
+      output_transform.header.stamp = time;
+  }
+  else
+    output_transform.header.stamp = time;
+}
+
+                                                       
+geometry_msgs::TransformStamped BufferCore::lookupTransform(const std::string& target_frame, 
+                                                        const ros::Time& target_time,
+                                                        const std::string& source_frame,
+                                                        const ros::Time& source_time,
+                                                        const std::string& fixed_frame) const
+{
+  validateFrameId("lookupTransform argument target_frame", target_frame);
+  validateFrameId("lookupTransform argument source_frame", source_frame);
+  validateFrameId("lookupTransform argument fixed_frame", fixed_frame);
+
+  geometry_msgs::TransformStamped output;
+  geometry_msgs::TransformStamped temp1 =  lookupTransform(fixed_frame, source_frame, source_time);
+  geometry_msgs::TransformStamped temp2 =  lookupTransform(target_frame, fixed_frame, target_time);
+  
+  tf2::Transform tf1, tf2;
+  transformMsgToTF2(temp1.transform, tf1);
+  transformMsgToTF2(temp2.transform, tf2);
+  transformTF2ToMsg(tf2*tf1, output.transform);
+  output.header.stamp = temp2.header.stamp;
+  output.header.frame_id = target_frame;
+  output.child_frame_id = source_frame;
+  return output;
+}
+
+size_t LookupBatch::add(const std::string& target_frame, const std::string& source_frame, const ros::Time& time)
+{
+  return add(target_frame, time, source_frame, time, std::string());
+}
+
+size_t LookupBatch::add(const std::string& target_frame, const ros::Time& target_time,
+                        const std::string& source_frame, const ros::Time& source_time,
+                        const std::string& fixed_frame)
+{
+  queries_.push_back(Query());
+  Query& q = queries_.back();
+  q.target_frame = target_frame;
+  q.source_frame = source_frame;
+  q.fixed_frame = fixed_frame;
+  q.target_time = target_time;
+  q.source_time = source_time;
+  q.target_id = q.source_id = q.fixed_id = 0;
+  q.error = tf2_msgs::TF2Error::NO_ERROR;
+  return queries_.size() - 1;
+}
+
+void LookupBatch::clear()
+{
+  queries_.clear();
+}
+
+const geometry_msgs::TransformStamped& LookupBatch::getTransform(size_t i) const
+{
+  const Query& q = queries_[i];
+  switch (q.error)
+  {
+  case tf2_msgs::TF2Error::NO_ERROR:
+    return q.transform;
+  case tf2_msgs::TF2Error::LOOKUP_ERROR:
+    throw LookupException(q.error_string);
+  case tf2_msgs::TF2Error::CONNECTIVITY_ERROR:
+    throw ConnectivityException(q.error_string);
+  case tf2_msgs::TF2Error::EXTRAPOLATION_ERROR:
+    throw ExtrapolationException(q.error_string);
+  case tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR:
+    throw InvalidArgumentException(q.error_string);
+  default:
+    throw TransformException(q.error_string);
+  }
+}
+
+void BufferCore::lookupTransforms(LookupBatch& batch) const
+{
+  // Resolve and validate the names first, this does not need the lock
+  for (size_t i = 0; i < batch.queries_.size(); ++i)
+  {
+    LookupBatch::Query& q = batch.queries_[i];
+    q.error = tf2_msgs::TF2Error::NO_ERROR;
+    q.error_string.clear();
+    try
+    {
+      if (!q.fixed_frame.empty())
+      {
+        q.target_id = validateFrameId("lookupTransforms argument target_frame", q.target_frame);
+        q.source_id = validateFrameId("lookupTransforms argument source_frame", q.source_frame);
+        q.fixed_id = validateFrameId("lookupTransforms argument fixed_frame", q.fixed_frame);
+      }
+      else if (q.target_frame == q.source_frame)
+      {
+        // Identity, which like lookupTransform does not need the frame to exist
+        q.target_id = q.source_id = lookupFrameNumber(q.target_frame);
+      }
+      else
+      {
+        q.target_id = validateFrameId("lookupTransforms argument target_frame", q.target_frame);
+        q.source_id = validateFrameId("lookupTransforms argument source_frame", q.source_frame);
+      }
+    }
+    catch (const InvalidArgumentException& ex)
+    {
+      q.error = tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR;
+      q.error_string = ex.what();
+    }
+    catch (const LookupException& ex)
+    {
+      q.error = tf2_msgs::TF2Error::LOOKUP_ERROR;
+      q.error_string = ex.what();
+    }
+  }
+
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
+  batch.paths_.clear();
+
+  for (size_t i = 0; i < batch.queries_.size(); ++i)
+  {
+    LookupBatch::Query& q = batch.queries_[i];
+    if (q.error != tf2_msgs::TF2Error::NO_ERROR)
+    {
+      continue;
+    }
+
+    tf2::Quaternion rotation;
+    tf2::Vector3 translation;
+    if (q.fixed_frame.empty())
+    {
+      ros::Time time = q.target_time;
+      q.error = lookupBatchedNoLock(batch, q.target_id, q.source_id, time, rotation, translation, q.error_string);
+      if (q.error == tf2_msgs::TF2Error::NO_ERROR)
+      {
+        transformTF2ToMsg(rotation, translation, q.transform, time, q.target_frame, q.source_frame);
+      }
+      continue;
+    }
+
+    ros::Time source_time = q.source_time;
+    q.error = lookupBatchedNoLock(batch, q.fixed_id, q.source_id, source_time, rotation, translation, q.error_string);
+    if (q.error != tf2_msgs::TF2Error::NO_ERROR)
+    {
+      continue;
+    }
+    tf2::Transform source_to_fixed(rotation, translation);
+
+    ros::Time target_time = q.target_time;
+    q.error = lookupBatchedNoLock(batch, q.target_id, q.fixed_id, target_time, rotation, translation, q.error_string);
+    if (q.error != tf2_msgs::TF2Error::NO_ERROR)
+    {
+      continue;
+    }
+    transformTF2ToMsg(tf2::Transform(rotation, translation) * source_to_fixed, q.transform, target_time,
+                      q.target_frame, q.source_frame);
+  }
+}
+
+int BufferCore::lookupBatchedNoLock(LookupBatch& batch, CompactFrameID target_id, CompactFrameID source_id, ros::Time& time,
+                                    tf2::Quaternion& rotation, tf2::Vector3& translation, std::string& error_string) const
+{
+  if (target_id == source_id)
+  {
+    rotation = tf2::Quaternion::getIdentity();
+    translation.setValue(0.0, 0.0, 0.0);
+    if (time == ros::Time())
+    {
+      TimeCacheInterfacePtr cache = getFrame(target_id);
+      if (cache)
+        time = cache->getLatestTimestamp();
+    }
+    return tf2_msgs::TF2Error::NO_ERROR;
+  }
+
+  if (time == ros::Time())
+  {
+    int retval = getLatestCommonTime(target_id, source_id, time, &error_string, batch.context_.lct_cache_);
+    if (retval != tf2_msgs::TF2Error::NO_ERROR)
+    {
+      return retval;
+    }
+  }
+
+  const LookupBatch::PathToTop& source_path = batchPathToTop(batch, source_id, time);
+  const LookupBatch::PathToTop& target_path = batchPathToTop(batch, target_id, time);
+  if (source_path.valid && target_path.valid && source_path.top == target_path.top)
+  {
+    tf2::Quaternion inv_target_quat = target_path.rotation.inverse();
+    tf2::Vector3 inv_target_vec = quatRotate(inv_target_quat, -target_path.translation);
+    translation = quatRotate(inv_target_quat, source_path.translation) + inv_target_vec;
+    rotation = inv_target_quat * source_path.rotation;
+    return tf2_msgs::TF2Error::NO_ERROR;
+  }
+
+  // The frames do not meet, let the regular walk find out why
+  TransformAccum accum;
+  int retval = walkToTopParent(accum, time, target_id, source_id, &error_string, NULL, &batch.context_);
+  if (retval == tf2_msgs::TF2Error::NO_ERROR)
+  {
+    rotation = accum.result_quat;
+    translation = accum.result_vec;
+  }
+  return retval;
+}
+
+const LookupBatch::PathToTop& BufferCore::batchPathToTop(LookupBatch& batch, CompactFrameID frame, ros::Time time) const
 {
-  validateFrameId("lookupTransform argument target_frame", target_frame);
-  validateFrameId("lookupTransform argument source_frame", source_frame);
-  validateFrameId("lookupTransform argument fixed_frame", fixed_frame);
+  // References to the elements of the map stay valid while more are inserted
+  uint64_t nsec = time.toNSec();
+  std::vector<std::pair<CompactFrameID, TransformStorage> >& pending = batch.pending_path_;
+  pending.clear();
+  const uint32_t max_depth = maxGraphDepthNoLock();
+
+  // Walk up until a frame whose path is known, or the top
+  const LookupBatch::PathToTop* known = NULL;
+  TransformStorage edge;
+  while (true)
+  {
+    boost::unordered_map<LookupBatch::FrameAndTime, LookupBatch::PathToTop>::const_iterator it =
+      batch.paths_.find(LookupBatch::FrameAndTime(frame, nsec));
+    if (it != batch.paths_.end())
+    {
+      known = &it->second;
+      break;
+    }
 
-  geometry_msgs::TransformStamped output;
-  geometry_msgs::TransformStamped temp1 =  lookupTransform(fixed_frame, source_frame, source_time);
-  geometry_msgs::TransformStamped temp2 =  lookupTransform(target_frame, fixed_frame, target_time);
-  
-  tf2::Transform tf1, tf2;
-  transformMsgToTF2(temp1.transform, tf1);
-  transformMsgToTF2(temp2.transform, tf2);
-  transformTF2ToMsg(tf2*tf1, output.transform);
-  output.header.stamp = temp2.header.stamp;
-  output.header.frame_id = target_frame;
-  output.child_frame_id = source_frame;
-  return output;
+    TimeCacheInterfacePtr cache = getFrame(frame);
+    if (!cache || !cache->getData(time, edge, NULL) || edge.frame_id_ == 0 || pending.size() > max_depth)
+    {
+      LookupBatch::PathToTop& top = batch.paths_[LookupBatch::FrameAndTime(frame, nsec)];
+      top.valid = pending.size() <= max_depth;
+      top.top = frame;
+      top.rotation = tf2::Quaternion::getIdentity();
+      top.translation.setValue(0.0, 0.0, 0.0);
+      known = &top;
+      break;
+    }
+
+    pending.push_back(std::make_pair(frame, edge));
+    frame = edge.frame_id_;
+  }
+
+  // Fill in the frames walked through, from the top down
+  for (size_t i = pending.size(); i-- > 0;)
+  {
+    const TransformStorage& st = pending[i].second;
+    LookupBatch::PathToTop& path = batch.paths_[LookupBatch::FrameAndTime(pending[i].first, nsec)];
+    path.valid = known->valid;
+    path.top = known->top;
+    path.translation = quatRotate(known->rotation, st.translation_) + known->translation;
+    path.rotation = known->rotation * st.rotation_;
+    known = &path;
+  }
+  return *known;
 }
 
 
@@ -795,7 +1441,7 @@ bool BufferCore::canTransformNoLock(CompactFrameID target_id, CompactFrameID sou
 bool BufferCore::canTransformInternal(CompactFrameID target_id, CompactFrameID source_id,
                                   const ros::Time& time, std::string* error_msg) const
 {
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   return canTransformNoLock(target_id, source_id, time, error_msg);
 }
 
@@ -811,8 +1457,6 @@ bool BufferCore::canTransform(const std::string& target_frame, const std::string
   if (warnFrameId("canTransform argument source_frame", source_frame))
     return false;
 
-  boost::mutex::scoped_lock lock(frame_mutex_);
-
   CompactFrameID target_id = lookupFrameNumber(target_frame);
   CompactFrameID source_id = lookupFrameNumber(source_frame);
 
@@ -835,6 +1479,8 @@ bool BufferCore::canTransform(const std::string& target_frame, const std::string
       }
     return false;
   }
+
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   return canTransformNoLock(target_id, source_id, time, error_msg);
 }
 
@@ -849,7 +1495,6 @@ bool BufferCore::canTransform(const std::string& target_frame, const ros::Time&
   if (warnFrameId("canTransform argument fixed_frame", fixed_frame))
     return false;
 
-  boost::mutex::scoped_lock lock(frame_mutex_);
   CompactFrameID target_id = lookupFrameNumber(target_frame);
   CompactFrameID source_id = lookupFrameNumber(source_frame);
   CompactFrameID fixed_id = lookupFrameNumber(fixed_frame);
@@ -881,6 +1526,8 @@ bool BufferCore::canTransform(const std::string& target_frame, const ros::Time&
       }
     return false;
   }
+
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   return canTransformNoLock(target_id, fixed_id, target_time, error_msg) && canTransformNoLock(fixed_id, source_id, source_time, error_msg);
 }
 
@@ -897,44 +1544,26 @@ tf2::TimeCacheInterfacePtr BufferCore::getFrame(CompactFrameID frame_id) const
 
 CompactFrameID BufferCore::lookupFrameNumber(const std::string& frameid_str) const
 {
-  CompactFrameID retval;
-  M_StringToCompactFrameID::const_iterator map_it = frameIDs_.find(frameid_str);
-  if (map_it == frameIDs_.end())
-  {
-    retval = CompactFrameID(0);
-  }
-  else
-    retval = map_it->second;
-  return retval;
+  return frame_registry_.lookup(frameid_str);
 }
 
 CompactFrameID BufferCore::lookupOrInsertFrameNumber(const std::string& frameid_str)
 {
-  CompactFrameID retval = 0;
-  M_StringToCompactFrameID::iterator map_it = frameIDs_.find(frameid_str);
-  if (map_it == frameIDs_.end())
-  {
-    retval = CompactFrameID(frames_.size());
-    frames_.push_back(TimeCacheInterfacePtr());//Just a place holder for iteration
-    frameIDs_[frameid_str] = retval;
-    frameIDs_reverse.push_back(frameid_str);
-  }
-  else
-    retval = frameIDs_[frameid_str];
-
-  return retval;
+  // The cache in frames_ is allocated with the first transform, see allocateFrame
+  return frame_registry_.lookupOrInsert(frameid_str);
 }
 
 const std::string& BufferCore::lookupFrameString(CompactFrameID frame_id_num) const
 {
-    if (frame_id_num >= frameIDs_reverse.size())
+    const std::string* frame_id = frame_registry_.lookupString(frame_id_num);
+    if (!frame_id)
     {
       std::stringstream ss;
       ss << "Reverse lookup of frame id " << frame_id_num << " failed!";
       throw tf2::LookupException(ss.str());
     }
     else
-      return frameIDs_reverse[frame_id_num];
+      return *frame_id;
 }
 
 void BufferCore::createConnectivityErrorString(CompactFrameID source_frame, CompactFrameID target_frame, std::string* out) const
@@ -948,9 +1577,49 @@ void BufferCore::createConnectivityErrorString(CompactFrameID source_frame, Comp
                      "Tf has two or more unconnected trees.");
 }
 
+void BufferCore::createLoopErrorString(CompactFrameID frame, std::string* out) const
+{
+  if (!out)
+  {
+    return;
+  }
+  *out = std::string("The tf tree is invalid because it contains a loop through frame '"+lookupFrameString(frame)+"'.");
+}
+
+bool BufferCore::closesLoopNoLock(const TimeCacheInterfacePtr& child_cache, CompactFrameID child, CompactFrameID parent,
+                                  const ros::Time& stamp) const
+{
+  // Only a new latest parent can close a loop, which keeps the walk off the common path. Older samples are
+  // not checked, the latest parents of the other frames say nothing about the tree at their stamp.
+  P_TimeAndFrameID latest = child_cache ? child_cache->getLatestTimeAndParent() : P_TimeAndFrameID(ros::Time(), 0);
+  if (latest.second == parent || stamp < latest.first)
+  {
+    return false;
+  }
+
+  CompactFrameID frame = parent;
+  for (uint32_t depth = 0; depth <= frames_.size() && frame != 0; ++depth)
+  {
+    if (frame == child)
+    {
+      return true;
+    }
+
+    TimeCacheInterfacePtr cache = getFrame(frame);
+    if (!cache)
+    {
+      return false;
+    }
+    frame = cache->getLatestTimeAndParent().second;
+  }
+
+  // Either the top of the tree, or a loop above parent which this transform does not close
+  return false;
+}
+
 std::string BufferCore::allFramesAsString() const
 {
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   return this->allFramesAsStringNoLock();
 }
 
@@ -975,7 +1644,7 @@ std::string BufferCore::allFramesAsStringNoLock() const
     {
       frame_id_num = 0;
     }
-    mstream << "Frame "<< frameIDs_reverse[counter] << " exists with parent " << frameIDs_reverse[frame_id_num] << "." <<std::endl;
+    mstream << "Frame "<< lookupFrameString(counter) << " exists with parent " << lookupFrameString(frame_id_num) << "." <<std::endl;
   }
 
   return mstream.str();
@@ -996,6 +1665,13 @@ struct TimeAndFrameIDFrameComparator
 };
 
 int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID source_id, ros::Time & time, std::string * error_string) const
+{
+  std::vector<P_TimeAndFrameID> lct_cache;
+  return getLatestCommonTime(target_id, source_id, time, error_string, lct_cache);
+}
+
+int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID source_id, ros::Time & time, std::string * error_string,
+                                    std::vector<P_TimeAndFrameID>& lct_cache) const
 {
   // Error if one of the frames don't exist.
   if (source_id == 0 || target_id == 0) return tf2_msgs::TF2Error::LOOKUP_ERROR;
@@ -1011,13 +1687,14 @@ int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID sou
     return tf2_msgs::TF2Error::NO_ERROR;
   }
 
-  std::vector<P_TimeAndFrameID> lct_cache;
+  lct_cache.clear();
 
   // Walk the tree to its root from the source frame, accumulating the list of parent/time as well as the latest time
   // in the target is a direct parent
   CompactFrameID frame = source_id;
   P_TimeAndFrameID temp;
   uint32_t depth = 0;
+  const uint32_t max_depth = maxGraphDepthNoLock();
   ros::Time common_time = ros::TIME_MAX;
   while (frame != 0)
   {
@@ -1058,15 +1735,9 @@ int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID sou
     }
 
     ++depth;
-    if (depth > MAX_GRAPH_DEPTH)
+    if (depth > max_depth)
     {
-      if (error_string)
-      {
-        std::stringstream ss;
-        ss<<"The tf tree is invalid because it contains a loop." << std::endl
-          << allFramesAsStringNoLock() << std::endl;
-        *error_string = ss.str();
-      }
+      createLoopErrorString(frame, error_string);
       return tf2_msgs::TF2Error::LOOKUP_ERROR;
     }
   }
@@ -1118,15 +1789,9 @@ int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID sou
     }
 
     ++depth;
-    if (depth > MAX_GRAPH_DEPTH)
+    if (depth > max_depth)
     {
-      if (error_string)
-      {
-        std::stringstream ss;
-        ss<<"The tf tree is invalid because it contains a loop." << std::endl
-          << allFramesAsStringNoLock() << std::endl;
-        *error_string = ss.str();
-      }
+      createLoopErrorString(frame, error_string);
       return tf2_msgs::TF2Error::LOOKUP_ERROR;
     }
   }
@@ -1167,7 +1832,7 @@ int BufferCore::getLatestCommonTime(CompactFrameID target_id, CompactFrameID sou
 std::string BufferCore::allFramesAsYAML(double current_time) const
 {
   std::stringstream mstream;
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
 
   TransformStorage temp;
 
@@ -1206,8 +1871,8 @@ std::string BufferCore::allFramesAsYAML(double current_time) const
 
     mstream << std::fixed; //fixed point notation
     mstream.precision(3); //3 decimal places
-    mstream << frameIDs_reverse[cfid] << ": " << std::endl;
-    mstream << "  parent: '" << frameIDs_reverse[frame_id_num] << "'" << std::endl;
+    mstream << lookupFrameString(cfid) << ": " << std::endl;
+    mstream << "  parent: '" << lookupFrameString(frame_id_num) << "'" << std::endl;
     mstream << "  broadcaster: '" << authority << "'" << std::endl;
     mstream << "  rate: " << rate << std::endl;
     mstream << "  most_recent_transform: " << (cache->getLatestTimestamp()).toSec() << std::endl;
@@ -1226,6 +1891,50 @@ std::string BufferCore::allFramesAsYAML() const
   return this->allFramesAsYAML(0.0);
 }
 
+void BufferCore::allFramesAsFrameInfo(std::vector<tf2_msgs::FrameInfo>& frames) const
+{
+  frames.clear();
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
+
+  TransformStorage temp;
+
+  frames.reserve(frames_.size());
+  for (unsigned int counter = 1; counter < frames_.size(); counter ++)//one referenced for 0 is no frame
+  {
+    CompactFrameID cfid = CompactFrameID(counter);
+    TimeCacheInterfacePtr cache = getFrame(cfid);
+    if (!cache)
+    {
+      continue;
+    }
+
+    if(!cache->getData(ros::Time(), temp))
+    {
+      continue;
+    }
+
+    frames.push_back(tf2_msgs::FrameInfo());
+    tf2_msgs::FrameInfo& info = frames.back();
+    info.frame_id = lookupFrameString(cfid);
+    info.parent_id = lookupFrameString(temp.frame_id_);
+
+    std::map<CompactFrameID, std::string>::const_iterator it = frame_authority_.find(cfid);
+    if (it != frame_authority_.end()) {
+      info.authority = it->second;
+    }
+    else {
+      info.authority = "no recorded authority";
+    }
+
+    info.most_recent_transform = cache->getLatestTimestamp();
+    info.oldest_transform = cache->getOldestTimestamp();
+    info.buffer_length = info.most_recent_transform - info.oldest_transform;
+    info.buffer_size = cache->getListLength();
+    info.rate = info.buffer_size / std::max(info.buffer_length.toSec(), 0.0001);
+    info.is_static = (dynamic_cast<StaticCache*>(cache.get()) != NULL);
+  }
+}
+
 TransformableCallbackHandle BufferCore::addTransformableCallback(const TransformableCallback& cb)
 {
   boost::mutex::scoped_lock lock(transformable_callbacks_mutex_);
@@ -1261,11 +1970,19 @@ void BufferCore::removeTransformableCallback(TransformableCallbackHandle handle)
 
   {
     boost::mutex::scoped_lock lock(transformable_requests_mutex_);
-    std::remove_if(transformable_requests_.begin(), transformable_requests_.end(), RemoveRequestByCallback(handle));
+    transformable_requests_.erase(std::remove_if(transformable_requests_.begin(), transformable_requests_.end(), RemoveRequestByCallback(handle)),
+                                  transformable_requests_.end());
   }
 }
 
-TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame, ros::Time time)
+TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame, ros::Time time,
+                                                               const ros::WallDuration& timeout)
+{
+  return addTransformableRequest(handle, target_frame, source_frame, time, time, timeout);
+}
+
+TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCallbackHandle handle, const std::string& target_frame, const std::string& source_frame,
+                                                               ros::Time time, ros::Time end_time, const ros::WallDuration& timeout)
 {
   // shortcut if target == source
   if (target_frame == source_frame)
@@ -1273,12 +1990,18 @@ TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCall
     return 0;
   }
 
+  if (end_time < time)
+  {
+    std::swap(time, end_time);
+  }
+
   TransformableRequest req;
   req.target_id = lookupFrameNumber(target_frame);
   req.source_id = lookupFrameNumber(source_frame);
 
   // First check if the request is already transformable.  If it is, return immediately
-  if (canTransformInternal(req.target_id, req.source_id, time, 0))
+  if (canTransformInternal(req.target_id, req.source_id, time, 0) &&
+      (end_time == time || canTransformInternal(req.target_id, req.source_id, end_time, 0)))
   {
     return 0;
   }
@@ -1298,6 +2021,7 @@ TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCall
 
   req.cb_handle = handle;
   req.time = time;
+  req.end_time = end_time;
   req.request_handle = ++transformable_requests_counter_;
   if (req.request_handle == 0 || req.request_handle == 0xffffffffffffffffULL)
   {
@@ -1317,6 +2041,19 @@ TransformableRequestHandle BufferCore::addTransformableRequest(TransformableCall
   boost::mutex::scoped_lock lock(transformable_requests_mutex_);
   transformable_requests_.push_back(req);
 
+  if (timeout > ros::WallDuration())
+  {
+    ros::WallTime now = ros::WallTime::now();
+    if (!transformable_requests_timers_)
+    {
+      // 10 ms ticks, with one revolution covering a bit more than 10 s
+      transformable_requests_timers_.reset(new TimerWheel(ros::WallDuration(0.01), 1024, now));
+      timeout_thread_ = boost::thread(boost::bind(&BufferCore::timeoutThread, this));
+    }
+    transformable_requests_timers_->insert(req.request_handle, now + timeout);
+    timeout_condition_.notify_all();
+  }
+
   return req.request_handle;
 }
 
@@ -1337,7 +2074,8 @@ struct BufferCore::RemoveRequestByID
 void BufferCore::cancelTransformableRequest(TransformableRequestHandle handle)
 {
   boost::mutex::scoped_lock lock(transformable_requests_mutex_);
-  std::remove_if(transformable_requests_.begin(), transformable_requests_.end(), RemoveRequestByID(handle));
+  transformable_requests_.erase(std::remove_if(transformable_requests_.begin(), transformable_requests_.end(), RemoveRequestByID(handle)),
+                                transformable_requests_.end());
 }
 
 
@@ -1358,14 +2096,14 @@ void BufferCore::_removeTransformsChangedListener(boost::signals2::connection c)
 
 bool BufferCore::_frameExists(const std::string& frame_id_str) const
 {
-  boost::mutex::scoped_lock lock(frame_mutex_);
-  return frameIDs_.count(frame_id_str);
+  CompactFrameID frame_id;
+  return frame_registry_.find(frame_id_str, frame_id);
 }
 
 bool BufferCore::_getParent(const std::string& frame_id, ros::Time time, std::string& parent) const
 {
 
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
   CompactFrameID frame_number = lookupFrameNumber(frame_id);
   TimeCacheInterfacePtr frame = getFrame(frame_number);
 
@@ -1384,14 +2122,12 @@ void BufferCore::_getFrameStrings(std::vector<std::string> & vec) const
 {
   vec.clear();
 
-  boost::mutex::scoped_lock lock(frame_mutex_);
-
-  TransformStorage temp;
-
-  //  for (std::vector< TimeCache*>::iterator  it = frames_.begin(); it != frames_.end(); ++it)
-  for (unsigned int counter = 1; counter < frameIDs_reverse.size(); counter ++)
+  // The registry is append only, so this needs no lock
+  CompactFrameID size = frame_registry_.size();
+  vec.reserve(size);
+  for (CompactFrameID counter = 1; counter < size; counter ++)
   {
-    vec.push_back(frameIDs_reverse[counter]);
+    vec.push_back(*frame_registry_.lookupString(counter));
   }
   return;
 }
@@ -1399,86 +2135,267 @@ void BufferCore::_getFrameStrings(std::vector<std::string> & vec) const
 
 
 
-void BufferCore::testTransformableRequests()
+void BufferCore::setTransformableRequestWorkers(unsigned int num_threads, size_t min_batch_size)
 {
+  boost::shared_ptr<WorkerPool> pool;
+  if (num_threads > 0)
+    pool.reset(new WorkerPool(num_threads));
+
   boost::mutex::scoped_lock lock(transformable_requests_mutex_);
-  V_TransformableRequest::iterator it = transformable_requests_.begin();
+  // A pool being replaced is kept alive by the threads still using it
+  transformable_requests_pool_ = pool;
+  transformable_requests_min_batch_ = std::max(min_batch_size, size_t(1));
+}
 
-  typedef boost::tuple<TransformableCallback&, TransformableRequestHandle, std::string,
-                       std::string, ros::Time&, TransformableResult&> TransformableTuple;
-  std::vector<TransformableTuple> transformables;
+unsigned int BufferCore::getTransformableRequestWorkers() const
+{
+  boost::mutex::scoped_lock lock(transformable_requests_mutex_);
+  return transformable_requests_pool_ ? transformable_requests_pool_->size() : 0;
+}
 
-  for (; it != transformable_requests_.end();)
+bool BufferCore::testTransformableRequestNoLock(TransformableRequest& req, TransformableResult& result,
+                                                std::vector<P_TimeAndFrameID>& lct_cache) const
+{
+  // One or both of the frames may not have existed when the request was originally made.
+  if (req.target_id == 0)
   {
-    TransformableRequest& req = *it;
+    req.target_id = lookupFrameNumber(req.target_string);
+  }
 
-    // One or both of the frames may not have existed when the request was originally made.
-    if (req.target_id == 0)
-    {
-      req.target_id = lookupFrameNumber(req.target_string);
-    }
+  if (req.source_id == 0)
+  {
+    req.source_id = lookupFrameNumber(req.source_string);
+  }
+
+  ros::Time latest_time;
+  // TODO: This is incorrect, but better than nothing.  Really we want the latest time for
+  // any of the frames
+  getLatestCommonTime(req.target_id, req.source_id, latest_time, 0, lct_cache);
+  if (!latest_time.isZero() && req.time + cache_time_ < latest_time)
+  {
+    result = TransformFailure;
+    return true;
+  }
+  else if (canTransformNoLock(req.target_id, req.source_id, req.time, 0) &&
+           (req.end_time == req.time || canTransformNoLock(req.target_id, req.source_id, req.end_time, 0)))
+  {
+    result = TransformAvailable;
+    return true;
+  }
+
+  return false;
+}
+
+namespace
+{
+
+/** \brief Outcome of testing one request, TRANSFORMABLE_PENDING or 1 + the TransformableResult */
+const uint8_t TRANSFORMABLE_PENDING = 0;
+
+
+/** \brief Chunk size which gives every thread of the pool a few chunks to balance with */
+size_t parallelGrain(size_t count, const WorkerPool& pool)
+{
+  return std::max(count / (4 * (pool.size() + 1)), size_t(16));
+}
+
+}
+
+struct BufferCore::TransformableDispatch
+{
+  const TransformableCallback* callback;
+  TransformableRequestHandle request_handle;
+  // Names live in the frame registry for as long as the buffer, or in the request
+  const std::string* target_frame;
+  const std::string* source_frame;
+  ros::Time time;
+  TransformableResult result;
+};
+
+void BufferCore::callTransformables(const std::vector<TransformableDispatch>* transformables, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    const TransformableDispatch& d = (*transformables)[i];
+    (*d.callback)(d.request_handle, *d.target_frame, *d.source_frame, d.time, d.result);
+  }
+}
+
+void BufferCore::addTransformableDispatch(const TransformableRequest& req, TransformableResult result,
+                                          std::vector<TransformableDispatch>& transformables) const
+{
+  M_TransformableCallback::const_iterator it = transformable_callbacks_.find(req.cb_handle);
+  if (it == transformable_callbacks_.end())
+  {
+    return;
+  }
+
+  TransformableDispatch d;
+  d.callback = &it->second;
+  d.request_handle = req.request_handle;
+  d.target_frame = req.target_id ? &lookupFrameString(req.target_id) : &req.target_string;
+  d.source_frame = req.source_id ? &lookupFrameString(req.source_id) : &req.source_string;
+  d.time = req.time;
+  d.result = result;
+  transformables.push_back(d);
+}
 
-    if (req.source_id == 0)
+void BufferCore::dispatchTransformables(const std::vector<TransformableDispatch>& transformables,
+                                        const boost::shared_ptr<WorkerPool>& pool, size_t min_batch)
+{
+  if (pool && transformables.size() >= min_batch)
+  {
+    if (pool->parallelFor(transformables.size(), parallelGrain(transformables.size(), *pool),
+                          boost::bind(&BufferCore::callTransformables, &transformables, _1, _2)))
     {
-      req.source_id = lookupFrameNumber(req.source_string);
+      return;
     }
+  }
 
-    ros::Time latest_time;
-    bool do_cb = false;
-    TransformableResult result = TransformAvailable;
-    // TODO: This is incorrect, but better than nothing.  Really we want the latest time for
-    // any of the frames
-    getLatestCommonTime(req.target_id, req.source_id, latest_time, 0);
-    if (!latest_time.isZero() && req.time + cache_time_ < latest_time)
+  callTransformables(&transformables, 0, transformables.size());
+}
+
+void BufferCore::testTransformableRequestRange(size_t begin, size_t end, std::vector<uint8_t>& outcomes)
+{
+  std::vector<P_TimeAndFrameID> lct_cache;
+  for (size_t i = begin; i < end; ++i)
+  {
+    TransformableResult result;
+    if (testTransformableRequestNoLock(transformable_requests_[i], result, lct_cache))
+      outcomes[i] = 1 + result;
+  }
+}
+
+void BufferCore::testTransformableRequests()
+{
+  boost::mutex::scoped_lock lock(transformable_requests_mutex_);
+  boost::shared_ptr<WorkerPool> pool = transformable_requests_pool_;
+  size_t min_batch = transformable_requests_min_batch_;
+  size_t count = transformable_requests_.size();
+
+  std::vector<uint8_t> outcomes(count, TRANSFORMABLE_PENDING);
+  bool tested = false;
+  if (pool && count >= min_batch)
+  {
+    // The workers only read the frames, so they share one hold of the frame mutex
+    boost::timed_mutex::scoped_lock frame_lock(frame_mutex_);
+    tested = pool->parallelFor(count, parallelGrain(count, *pool),
+                               boost::bind(&BufferCore::testTransformableRequestRange, this, _1, _2, boost::ref(outcomes)));
+  }
+  if (!tested)
+  {
+    std::vector<P_TimeAndFrameID> lct_cache;
+    for (size_t i = 0; i < count; ++i)
     {
-      do_cb = true;
-      result = TransformFailure;
+      boost::timed_mutex::scoped_lock frame_lock(frame_mutex_);
+      TransformableResult result;
+      if (testTransformableRequestNoLock(transformable_requests_[i], result, lct_cache))
+        outcomes[i] = 1 + result;
     }
-    else if (canTransformInternal(req.target_id, req.source_id, req.time, 0))
+  }
+
+  std::vector<TransformableDispatch> transformables;
+  size_t kept = 0;
+  {
+    boost::mutex::scoped_lock lock2(transformable_callbacks_mutex_);
+    for (size_t i = 0; i < count; ++i)
     {
-      do_cb = true;
-      result = TransformAvailable;
+      TransformableRequest& req = transformable_requests_[i];
+      if (outcomes[i] == TRANSFORMABLE_PENDING)
+      {
+        if (kept != i)
+          std::swap(transformable_requests_[kept], req);
+        ++kept;
+        continue;
+      }
+
+      // A finished request knows both of its frames, so req does not need to outlive the dispatch
+      addTransformableDispatch(req, TransformableResult(outcomes[i] - 1), transformables);
     }
+  }
+  transformable_requests_.resize(kept);
+
+  // unlock before allowing possible user callbacks to avoid potential deadlock (#91)
+  lock.unlock();
+
+  dispatchTransformables(transformables, pool, min_batch);
+
+  // Backwards compatability callback for tf
+  _transforms_changed_();
+}
+
+void BufferCore::expireTransformableRequests()
+{
+  boost::mutex::scoped_lock lock(transformable_requests_mutex_);
+  if (!transformable_requests_timers_)
+  {
+    return;
+  }
+
+  // Requests which were answered or cancelled since are not in transformable_requests_ anymore
+  std::vector<uint64_t> expired;
+  transformable_requests_timers_->advance(ros::WallTime::now(), expired);
+  if (expired.empty())
+  {
+    return;
+  }
+  std::sort(expired.begin(), expired.end());
 
-    if (do_cb)
+  // The callbacks may refer to the frame names of the requests, which are moved out of the way
+  V_TransformableRequest expired_requests;
+  expired_requests.reserve(expired.size());
+  std::vector<TransformableDispatch> transformables;
+  size_t kept = 0;
+  {
+    boost::mutex::scoped_lock lock2(transformable_callbacks_mutex_);
+    for (size_t i = 0; i < transformable_requests_.size(); ++i)
     {
+      TransformableRequest& req = transformable_requests_[i];
+      if (std::binary_search(expired.begin(), expired.end(), req.request_handle))
       {
-        boost::mutex::scoped_lock lock2(transformable_callbacks_mutex_);
-        M_TransformableCallback::iterator it = transformable_callbacks_.find(req.cb_handle);
-        if (it != transformable_callbacks_.end())
-        {
-          transformables.push_back(boost::make_tuple(boost::ref(it->second),
-                                                     req.request_handle,
-                                                     lookupFrameString(req.target_id),
-                                                     lookupFrameString(req.source_id),
-                                                     boost::ref(req.time),
-                                                     boost::ref(result)));
-        }
+        expired_requests.push_back(TransformableRequest());
+        std::swap(expired_requests.back(), req);
+        addTransformableDispatch(expired_requests.back(), TransformTimeout, transformables);
       }
-
-      if (transformable_requests_.size() > 1)
+      else
       {
-        transformable_requests_[it - transformable_requests_.begin()] = transformable_requests_.back();
+        if (kept != i)
+          std::swap(transformable_requests_[kept], req);
+        ++kept;
       }
-
-      transformable_requests_.erase(transformable_requests_.end() - 1);
-    }
-    else
-    {
-      ++it;
     }
   }
+  transformable_requests_.resize(kept);
 
-  // unlock before allowing possible user callbacks to avoid potential deadlock (#91)
+  boost::shared_ptr<WorkerPool> pool = transformable_requests_pool_;
+  size_t min_batch = transformable_requests_min_batch_;
   lock.unlock();
 
-  BOOST_FOREACH (TransformableTuple tt, transformables)
+  dispatchTransformables(transformables, pool, min_batch);
+}
+
+void BufferCore::timeoutThread()
+{
+  boost::mutex::scoped_lock lock(transformable_requests_mutex_);
+  while (!timeout_thread_shutdown_)
   {
-    tt.get<0>()(tt.get<1>(), tt.get<2>(), tt.get<3>(), tt.get<4>(), tt.get<5>());
-  }
+    if (transformable_requests_timers_->size() == 0)
+    {
+      timeout_condition_.wait(lock);
+      continue;
+    }
 
-  // Backwards compatability callback for tf
-  _transforms_changed_();
+    ros::WallDuration wait = transformable_requests_timers_->nextTick() - ros::WallTime::now();
+    if (wait > ros::WallDuration())
+    {
+      timeout_condition_.timed_wait(lock, boost::posix_time::microseconds(wait.toNSec() / 1000 + 1));
+      continue;
+    }
+
+    lock.unlock();
+    expireTransformableRequests();
+    lock.lock();
+  }
 }
 
 
@@ -1486,7 +2403,7 @@ std::string BufferCore::_allFramesAsDot(double current_time) const
 {
   std::stringstream mstream;
   mstream << "digraph G {" << std::endl;
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
 
   TransformStorage temp;
 
@@ -1518,8 +2435,8 @@ std::string BufferCore::_allFramesAsDot(double current_time) const
 
     mstream << std::fixed; //fixed point notation
     mstream.precision(3); //3 decimal places
-    mstream << "\"" << frameIDs_reverse[frame_id_num] << "\"" << " -> "
-            << "\"" << frameIDs_reverse[counter] << "\"" << "[label=\""
+    mstream << "\"" << lookupFrameString(frame_id_num) << "\"" << " -> "
+            << "\"" << lookupFrameString(counter) << "\"" << "[label=\""
       //<< "Time: " << current_time.toSec() << "\\n"
             << "Broadcaster: " << authority << "\\n"
             << "Average rate: " << rate << " Hz\\n"
@@ -1543,7 +2460,7 @@ std::string BufferCore::_allFramesAsDot(double current_time) const
         mstream << "edge [style=invis];" <<std::endl;
         mstream << " subgraph cluster_legend { style=bold; color=black; label =\"view_frames Result\";\n"
                 << "\"Recorded at time: " << current_time << "\"[ shape=plaintext ] ;\n "
-                << "}" << "->" << "\"" << frameIDs_reverse[counter] << "\";" << std::endl;
+                << "}" << "->" << "\"" << lookupFrameString(counter) << "\";" << std::endl;
       }
       continue;
     }
@@ -1553,13 +2470,13 @@ std::string BufferCore::_allFramesAsDot(double current_time) const
     	frame_id_num = 0;
     }
 
-    if(frameIDs_reverse[frame_id_num]=="NO_PARENT")
+    if(lookupFrameString(frame_id_num)=="NO_PARENT")
     {
       mstream << "edge [style=invis];" <<std::endl;
       mstream << " subgraph cluster_legend { style=bold; color=black; label =\"view_frames Result\";\n";
       if (current_time > 0)
         mstream << "\"Recorded at time: " << current_time << "\"[ shape=plaintext ] ;\n ";
-      mstream << "}" << "->" << "\"" << frameIDs_reverse[counter] << "\";" << std::endl;
+      mstream << "}" << "->" << "\"" << lookupFrameString(counter) << "\";" << std::endl;
     }
   }
   mstream << "}";
@@ -1573,12 +2490,19 @@ std::string BufferCore::_allFramesAsDot() const
 
 void BufferCore::_chainAsVector(const std::string & target_frame, ros::Time target_time, const std::string & source_frame, ros::Time source_time, const std::string& fixed_frame, std::vector<std::string>& output) const
 {
-  std::string error_string;
+  LookupContext context;
+  _chainAsVector(target_frame, target_time, source_frame, source_time, fixed_frame, output, context);
+}
+
+void BufferCore::_chainAsVector(const std::string & target_frame, ros::Time target_time, const std::string & source_frame, ros::Time source_time, const std::string& fixed_frame, std::vector<std::string>& output, LookupContext& context) const
+{
+  std::string& error_string = context.error_string_;
+  error_string.clear();
 
   output.clear(); //empty vector
 
   std::stringstream mstream;
-  boost::mutex::scoped_lock lock(frame_mutex_);
+  boost::timed_mutex::scoped_lock lock(frame_mutex_);
 
   TransformAccum accum;
 
@@ -1587,8 +2511,8 @@ void BufferCore::_chainAsVector(const std::string & target_frame, ros::Time targ
   CompactFrameID fixed_id = lookupFrameNumber(fixed_frame);
   CompactFrameID target_id = lookupFrameNumber(target_frame);
 
-  std::vector<CompactFrameID> source_frame_chain;
-  int retval = walkToTopParent(accum, source_time, fixed_id, source_id, &error_string, &source_frame_chain);
+  std::vector<CompactFrameID>& source_frame_chain = context.source_frame_chain_;
+  int retval = walkToTopParent(accum, source_time, fixed_id, source_id, &error_string, &source_frame_chain, &context);
 
   if (retval != tf2_msgs::TF2Error::NO_ERROR)
   {
@@ -1606,8 +2530,8 @@ void BufferCore::_chainAsVector(const std::string & target_frame, ros::Time targ
     }
   }
 
-  std::vector<CompactFrameID> target_frame_chain;
-  retval = walkToTopParent(accum, target_time, target_id, fixed_id, &error_string, &target_frame_chain);
+  std::vector<CompactFrameID>& target_frame_chain = context.target_frame_chain_;
+  retval = walkToTopParent(accum, target_time, target_id, fixed_id, &error_string, &target_frame_chain, &context);
 
   if (retval != tf2_msgs::TF2Error::NO_ERROR)
   {
@@ -56,10 +56,19 @@ TransformStorage::TransformStorage(const geometry_msgs::TransformStamped& data,
   translation_ = tf2::Vector3(v.x, v.y, v.z);
 }
 
-TimeCache::TimeCache(ros::Duration max_storage_time)
+template <typename StorageT>
+TimeCacheBase<StorageT>::TimeCacheBase(ros::Duration max_storage_time)
 : max_storage_time_(max_storage_time)
 {}
 
+TimeCache::TimeCache(ros::Duration max_storage_time)
+: TimeCacheBase<TransformStorage>(max_storage_time)
+{}
+
+CompactTimeCache::CompactTimeCache(ros::Duration max_storage_time)
+: TimeCacheBase<CompactTransformStorage>(max_storage_time)
+{}
+
 namespace cache { // Avoid ODR collisions https://github.com/ros/geometry2/issues/175 
 // hoisting these into separate functions causes an ~8% speedup.  Removing calling them altogether adds another ~10%
 void createExtrapolationException1(ros::Time t0, ros::Time t1, std::string* error_str)
@@ -106,7 +115,13 @@ bool operator>(const TransformStorage& lhs, const TransformStorage& rhs)
   return lhs.stamp_ > rhs.stamp_;
 }
 
-uint8_t TimeCache::findClosest(TransformStorage*& one, TransformStorage*& two, ros::Time target_time, std::string* error_str)
+bool operator>(const CompactTransformStorage& lhs, const CompactTransformStorage& rhs)
+{
+  return lhs.stamp_ > rhs.stamp_;
+}
+
+template <typename StorageT>
+uint8_t TimeCacheBase<StorageT>::findClosest(StorageT*& one, StorageT*& two, ros::Time target_time, std::string* error_str)
 {
   //No values stored
   if (storage_.empty())
@@ -124,7 +139,7 @@ uint8_t TimeCache::findClosest(TransformStorage*& one, TransformStorage*& two, r
   // One value stored
   if (++storage_.begin() == storage_.end())
   {
-    TransformStorage& ts = *storage_.begin();
+    StorageT& ts = *storage_.begin();
     if (ts.stamp_ == target_time)
     {
       one = &ts;
@@ -164,14 +179,14 @@ uint8_t TimeCache::findClosest(TransformStorage*& one, TransformStorage*& two, r
 
   //At least 2 values stored
   //Find the first value less than the target value
-  L_TransformStorage::iterator storage_it;
-  TransformStorage storage_target_time;
+  typename L_TransformStorage::iterator storage_it;
+  StorageT storage_target_time;
   storage_target_time.stamp_ = target_time;
 
   storage_it = std::lower_bound(
       storage_.begin(),
       storage_.end(),
-      storage_target_time, std::greater<TransformStorage>());
+      storage_target_time, std::greater<StorageT>());
 
   //Finally the case were somewhere in the middle  Guarenteed no extrapolation :-)
   one = &*(storage_it); //Older
@@ -181,7 +196,8 @@ uint8_t TimeCache::findClosest(TransformStorage*& one, TransformStorage*& two, r
 
 }
 
-void TimeCache::interpolate(const TransformStorage& one, const TransformStorage& two, ros::Time time, TransformStorage& output)
+namespace cache {
+void interpolate(const TransformStorage& one, const TransformStorage& two, ros::Time time, TransformStorage& output)
 {
   // Check for zero distance case
   if( two.stamp_ == one.stamp_ )
@@ -203,10 +219,31 @@ void TimeCache::interpolate(const TransformStorage& one, const TransformStorage&
   output.child_frame_id_ = one.child_frame_id_;
 }
 
-bool TimeCache::getData(ros::Time time, TransformStorage & data_out, std::string* error_str) //returns false if data not available
+void interpolate(const CompactTransformStorage& one, const CompactTransformStorage& two, ros::Time time, TransformStorage& output)
 {
-  TransformStorage* p_temp_1;
-  TransformStorage* p_temp_2;
+  // Widen both samples and interpolate in double precision
+  TransformStorage wide_one, wide_two;
+  one.toTransformStorage(wide_one);
+  two.toTransformStorage(wide_two);
+  interpolate(wide_one, wide_two, time, output);
+}
+
+inline void widen(const TransformStorage& in, TransformStorage& out)
+{
+  out = in;
+}
+
+inline void widen(const CompactTransformStorage& in, TransformStorage& out)
+{
+  in.toTransformStorage(out);
+}
+} // namespace cache
+
+template <typename StorageT>
+bool TimeCacheBase<StorageT>::getData(ros::Time time, TransformStorage & data_out, std::string* error_str) //returns false if data not available
+{
+  StorageT* p_temp_1;
+  StorageT* p_temp_2;
 
   int num_nodes = findClosest(p_temp_1, p_temp_2, time, error_str);
   if (num_nodes == 0)
@@ -215,17 +252,17 @@ bool TimeCache::getData(ros::Time time, TransformStorage & data_out, std::string
   }
   else if (num_nodes == 1)
   {
-    data_out = *p_temp_1;
+    cache::widen(*p_temp_1, data_out);
   }
   else if (num_nodes == 2)
   {
     if( p_temp_1->frame_id_ == p_temp_2->frame_id_)
     {
-      interpolate(*p_temp_1, *p_temp_2, time, data_out);
+      cache::interpolate(*p_temp_1, *p_temp_2, time, data_out);
     }
     else
     {
-      data_out = *p_temp_1;
+      cache::widen(*p_temp_1, data_out);
     }
   }
   else
@@ -236,10 +273,11 @@ bool TimeCache::getData(ros::Time time, TransformStorage & data_out, std::string
   return true;
 }
 
-CompactFrameID TimeCache::getParent(ros::Time time, std::string* error_str)
+template <typename StorageT>
+CompactFrameID TimeCacheBase<StorageT>::getParent(ros::Time time, std::string* error_str)
 {
-  TransformStorage* p_temp_1;
-  TransformStorage* p_temp_2;
+  StorageT* p_temp_1;
+  StorageT* p_temp_2;
 
   int num_nodes = findClosest(p_temp_1, p_temp_2, time, error_str);
   if (num_nodes == 0)
@@ -250,9 +288,10 @@ CompactFrameID TimeCache::getParent(ros::Time time, std::string* error_str)
   return p_temp_1->frame_id_;
 }
 
-bool TimeCache::insertData(const TransformStorage& new_data, std::string* error_str)
+template <typename StorageT>
+bool TimeCacheBase<StorageT>::insertData(const TransformStorage& new_data, std::string* error_str)
 {
-  L_TransformStorage::iterator storage_it = storage_.begin();
+  typename L_TransformStorage::iterator storage_it = storage_.begin();
 
   if(storage_it != storage_.end())
   {
@@ -260,20 +299,30 @@ bool TimeCache::insertData(const TransformStorage& new_data, std::string* error_
     {
       if (error_str)
       {
-        *error_str = "TF_OLD_DATA ignoring data from the past (Possible reasons are listed at http://wiki.ros.org/tf/Errors%%20explained)";
+        *error_str = "TF_OLD_DATA ignoring data from the past (Possible reasons are listed at http://wiki.ros.org/tf/Errors%20explained)";
       }
       return false;
     }
   }
 
-
-  while(storage_it != storage_.end())
+  // Fast path: in order data always goes to the front
+  StorageT stored_data(new_data);
+  if (storage_it == storage_.end() || storage_it->stamp_ < stored_data.stamp_)
   {
-    if (storage_it->stamp_ <= new_data.stamp_)
-      break;
-    storage_it++;
+    storage_.push_front(stored_data);
+    pruneList();
+    return true;
   }
-  if (storage_it != storage_.end() && storage_it->stamp_ == new_data.stamp_)
+
+  // Late data: binary search for the first element not newer than the new data.
+  // Inserting into the deque only moves the elements on the shorter side, so
+  // data which is late by a bounded amount is still cheap to place.
+  storage_it = std::lower_bound(
+      storage_.begin(),
+      storage_.end(),
+      stored_data, std::greater<StorageT>());
+
+  if (storage_it != storage_.end() && storage_it->stamp_ == stored_data.stamp_)
   {
     if (error_str)
     {
@@ -283,47 +332,83 @@ bool TimeCache::insertData(const TransformStorage& new_data, std::string* error_
   }
   else
   {
-    storage_.insert(storage_it, new_data);
+    storage_.insert(storage_it, stored_data);
   }
 
   pruneList();
   return true;
 }
 
-void TimeCache::clearList()
+template <typename StorageT>
+void TimeCacheBase<StorageT>::clearList()
 {
   storage_.clear();
 }
 
-unsigned int TimeCache::getListLength()
+template <typename StorageT>
+void TimeCacheBase<StorageT>::setMaxStorageTime(ros::Duration max_storage_time)
+{
+  max_storage_time_ = max_storage_time;
+}
+
+template <typename StorageT>
+void TimeCacheBase<StorageT>::clearAfter(ros::Time time)
+{
+  // The newest data is at the front, so only the entries past time are touched
+  while (!storage_.empty() && storage_.front().stamp_ > time)
+  {
+    storage_.pop_front();
+  }
+}
+
+template <typename StorageT>
+void TimeCacheBase<StorageT>::getDataSince(ros::Time start, std::vector<TransformStorage>& data_out)
+{
+  // The newest data is at the front
+  for (typename L_TransformStorage::reverse_iterator it = storage_.rbegin(); it != storage_.rend(); ++it)
+  {
+    if (it->stamp_ >= start)
+    {
+      data_out.push_back(TransformStorage());
+      cache::widen(*it, data_out.back());
+    }
+  }
+}
+
+template <typename StorageT>
+unsigned int TimeCacheBase<StorageT>::getListLength()
 {
   return storage_.size();
 }
 
-P_TimeAndFrameID TimeCache::getLatestTimeAndParent()
+template <typename StorageT>
+P_TimeAndFrameID TimeCacheBase<StorageT>::getLatestTimeAndParent()
 {
   if (storage_.empty())
   {
     return std::make_pair(ros::Time(), 0);
   }
 
-  const TransformStorage& ts = storage_.front();
+  const StorageT& ts = storage_.front();
   return std::make_pair(ts.stamp_, ts.frame_id_);
 }
 
-ros::Time TimeCache::getLatestTimestamp() 
+template <typename StorageT>
+ros::Time TimeCacheBase<StorageT>::getLatestTimestamp() 
 {   
   if (storage_.empty()) return ros::Time(); //empty list case
   return storage_.front().stamp_;
 }
 
-ros::Time TimeCache::getOldestTimestamp() 
+template <typename StorageT>
+ros::Time TimeCacheBase<StorageT>::getOldestTimestamp() 
 {   
   if (storage_.empty()) return ros::Time(); //empty list case
   return storage_.back().stamp_;
 }
 
-void TimeCache::pruneList()
+template <typename StorageT>
+void TimeCacheBase<StorageT>::pruneList()
 {
   ros::Time latest_time = storage_.begin()->stamp_;
   
@@ -332,5 +417,10 @@ void TimeCache::pruneList()
     storage_.pop_back();
   }
   
-} // namespace tf2
 }
+
+// The caches of full and of single precision samples
+template class TimeCacheBase<TransformStorage>;
+template class TimeCacheBase<CompactTransformStorage>;
+
+} // namespace tf2
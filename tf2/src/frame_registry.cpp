@@ -0,0 +1,171 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include "tf2/frame_registry.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <stdexcept>
+
+namespace tf2
+{
+
+FrameRegistry::Table::Table(std::size_t capacity)
+: mask(capacity - 1)
+, slots(capacity)
+{
+  for (std::size_t i = 0; i < capacity; ++i)
+    slots[i].store(0, std::memory_order_relaxed);
+}
+
+FrameRegistry::FrameRegistry()
+: size_(0)
+, table_(new Table(2 * FIRST_SEGMENT_SIZE))
+{
+  for (std::size_t k = 0; k < MAX_SEGMENTS; ++k)
+    segments_[k] = NULL;
+}
+
+FrameRegistry::~FrameRegistry()
+{
+  for (std::size_t k = 0; k < MAX_SEGMENTS; ++k)
+    delete[] segments_[k];
+  for (std::size_t i = 0; i < retired_tables_.size(); ++i)
+    delete retired_tables_[i];
+  delete table_.load(std::memory_order_relaxed);
+}
+
+void FrameRegistry::locate(CompactFrameID id, std::size_t& segment, std::size_t& offset)
+{
+  std::size_t index = std::size_t(id) + FIRST_SEGMENT_SIZE;
+  segment = 0;
+  while ((index >> segment) >= 2 * FIRST_SEGMENT_SIZE)
+    ++segment;
+  offset = index - (FIRST_SEGMENT_SIZE << segment);
+}
+
+const FrameRegistry::Entry& FrameRegistry::entry(CompactFrameID id) const
+{
+  std::size_t k, offset;
+  locate(id, k, offset);
+  return segments_[k][offset];
+}
+
+bool FrameRegistry::find(const std::string& name, CompactFrameID& id) const
+{
+  std::size_t hash = boost::hash<std::string>()(name);
+  const Table* table = table_.load(std::memory_order_acquire);
+  for (std::size_t i = hash & table->mask; ; i = (i + 1) & table->mask)
+  {
+    uint32_t slot = table->slots[i].load(std::memory_order_acquire);
+    if (slot == 0)
+      return false;
+
+    const Entry& e = entry(slot - 1);
+    if (e.hash == hash && e.name == name)
+    {
+      // Ids are only published once size_ covers them, so both directions agree
+      if (slot - 1 >= size_.load(std::memory_order_acquire))
+        return false;
+      id = slot - 1;
+      return true;
+    }
+  }
+}
+
+CompactFrameID FrameRegistry::lookupOrInsert(const std::string& name)
+{
+  boost::mutex::scoped_lock lock(write_mutex_);
+
+  std::size_t hash = boost::hash<std::string>()(name);
+  Table* table = table_.load(std::memory_order_relaxed);
+  std::size_t i = hash & table->mask;
+  for (; ; i = (i + 1) & table->mask)
+  {
+    uint32_t slot = table->slots[i].load(std::memory_order_relaxed);
+    if (slot == 0)
+      break;
+
+    const Entry& e = entry(slot - 1);
+    if (e.hash == hash && e.name == name)
+      return slot - 1;
+  }
+
+  CompactFrameID id = size_.load(std::memory_order_relaxed);
+  std::size_t k, offset;
+  locate(id, k, offset);
+  if (k >= MAX_SEGMENTS)
+    throw std::length_error("tf2::FrameRegistry is full");
+  if (!segments_[k])
+    segments_[k] = new Entry[FIRST_SEGMENT_SIZE << k];
+
+  Entry& e = segments_[k][offset];
+  e.name = name;
+  e.hash = hash;
+
+  if (2 * (std::size_t(id) + 1) <= table->mask + 1)
+  {
+    table->slots[i].store(id + 1, std::memory_order_release);
+  }
+  else
+  {
+    // Over half full, publish a rehashed copy of twice the size instead
+    Table* grown = new Table(2 * (table->mask + 1));
+    for (CompactFrameID j = 0; j <= id; ++j)
+      insertSlot(*grown, entry(j).hash, j);
+    table_.store(grown, std::memory_order_release);
+    retired_tables_.push_back(table);
+  }
+
+  size_.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+void FrameRegistry::insertSlot(Table& table, std::size_t hash, CompactFrameID id)
+{
+  std::size_t i = hash & table.mask;
+  while (table.slots[i].load(std::memory_order_relaxed) != 0)
+    i = (i + 1) & table.mask;
+  table.slots[i].store(id + 1, std::memory_order_release);
+}
+
+const std::string* FrameRegistry::lookupString(CompactFrameID id) const
+{
+  if (id >= size_.load(std::memory_order_acquire))
+    return NULL;
+  return &entry(id).name;
+}
+
+}
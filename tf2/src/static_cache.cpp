@@ -37,6 +37,11 @@
 
 using namespace tf2;
 
+StaticCache::StaticCache()
+{
+  // No parent until the first insertion
+  storage_.frame_id_ = 0;
+}
 
 bool StaticCache::getData(ros::Time time, TransformStorage & data_out, std::string* error_str) //returns false if data not available
 {
@@ -56,6 +61,15 @@ bool StaticCache::insertData(const TransformStorage& new_data, std::string* erro
 
 void StaticCache::clearList() { return; };
 
+void StaticCache::clearAfter(ros::Time time) { return; };
+
+void StaticCache::getDataSince(ros::Time start, std::vector<TransformStorage>& data_out)
+{
+  // Static data holds for all time
+  if (storage_.frame_id_ != 0)
+    data_out.push_back(storage_);
+}
+
 unsigned int StaticCache::getListLength() {   return 1; };
 
 CompactFrameID StaticCache::getParent(ros::Time time, std::string* error_str)
@@ -0,0 +1,110 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace tf2
+{
+
+TimerWheel::TimerWheel(const ros::WallDuration& resolution, size_t num_slots, const ros::WallTime& start)
+: resolution_ns_(std::max(resolution.toNSec(), int64_t(1)))
+, origin_(start)
+, current_tick_(0)
+, size_(0)
+, slots_(std::max(num_slots, size_t(1)))
+{
+}
+
+int64_t TimerWheel::tickOf(const ros::WallTime& time) const
+{
+  int64_t ns = (time - origin_).toNSec();
+  if (ns <= 0)
+    return 0;
+  return ns / resolution_ns_;
+}
+
+void TimerWheel::insert(uint64_t id, const ros::WallTime& deadline)
+{
+  // Round up, so that a timer never fires before its deadline
+  int64_t ns = (deadline - origin_).toNSec();
+  int64_t tick = ns <= 0 ? 0 : (ns + resolution_ns_ - 1) / resolution_ns_;
+  tick = std::max(tick, current_tick_ + 1);
+
+  Timer timer;
+  timer.id = id;
+  timer.tick = tick;
+  slots_[tick % slots_.size()].push_back(timer);
+  ++size_;
+}
+
+void TimerWheel::advance(const ros::WallTime& now, std::vector<uint64_t>& expired)
+{
+  int64_t now_tick = tickOf(now);
+  if (now_tick <= current_tick_)
+    return;
+
+  // After a full revolution every slot has been visited once
+  int64_t last = std::min(now_tick, current_tick_ + int64_t(slots_.size()));
+  for (int64_t tick = current_tick_ + 1; tick <= last && size_ > 0; ++tick)
+  {
+    std::vector<Timer>& slot = slots_[tick % slots_.size()];
+    for (size_t i = 0; i < slot.size();)
+    {
+      if (slot[i].tick <= now_tick)
+      {
+        expired.push_back(slot[i].id);
+        slot[i] = slot.back();
+        slot.pop_back();
+        --size_;
+      }
+      else
+      {
+        ++i;
+      }
+    }
+  }
+  current_tick_ = now_tick;
+}
+
+ros::WallTime TimerWheel::nextTick() const
+{
+  ros::WallDuration offset;
+  offset.fromNSec((current_tick_ + 1) * resolution_ns_);
+  return origin_ + offset;
+}
+
+}
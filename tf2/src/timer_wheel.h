@@ -0,0 +1,91 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef TF2_TIMER_WHEEL_H
+#define TF2_TIMER_WHEEL_H
+
+#include <ros/time.h>
+
+#include <vector>
+
+namespace tf2
+{
+
+/** \brief Hashed timing wheel of ids with deadlines.
+ *
+ * Time is cut into ticks of a fixed resolution, and a timer lives in the slot of its deadline tick
+ * modulo the number of slots, so insertion is O(1). Advancing the wheel only visits the slots of
+ * the ticks which passed; timers further away than one revolution stay in their slot and are
+ * skipped until their round comes. Timers are never removed early, the owner of the ids ignores
+ * expired ids which it does not know anymore.
+ * Not thread safe.
+ */
+class TimerWheel
+{
+public:
+  TimerWheel(const ros::WallDuration& resolution, size_t num_slots, const ros::WallTime& start);
+
+  /** \brief Add a timer which expires once the wheel advances past deadline */
+  void insert(uint64_t id, const ros::WallTime& deadline);
+
+  /** \brief Advance the wheel to now and append the ids of all timers whose deadline passed */
+  void advance(const ros::WallTime& now, std::vector<uint64_t>& expired);
+
+  /** \brief Number of timers in the wheel */
+  size_t size() const { return size_; }
+
+  /** \brief The time at which the next tick is due */
+  ros::WallTime nextTick() const;
+
+private:
+  struct Timer
+  {
+    uint64_t id;
+    int64_t tick;
+  };
+
+  int64_t tickOf(const ros::WallTime& time) const;
+
+  int64_t resolution_ns_;
+  ros::WallTime origin_;
+  /// The last tick that was processed
+  int64_t current_tick_;
+  size_t size_;
+  std::vector<std::vector<Timer> > slots_;
+};
+
+}
+
+#endif // TF2_TIMER_WHEEL_H
@@ -0,0 +1,159 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include "worker_pool.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <exception>
+
+namespace tf2
+{
+
+WorkerPool::WorkerPool(unsigned int num_threads)
+: num_threads_(num_threads)
+, generation_(0)
+, busy_workers_(0)
+, shutdown_(false)
+, function_(NULL)
+, count_(0)
+, grain_(1)
+, next_(0)
+{
+  for (unsigned int i = 0; i < num_threads_; ++i)
+    threads_.create_thread(boost::bind(&WorkerPool::workerThread, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    shutdown_ = true;
+  }
+  work_condition_.notify_all();
+  threads_.join_all();
+}
+
+bool WorkerPool::parallelFor(std::size_t count, std::size_t grain, const RangeFunction& function)
+{
+  boost::mutex::scoped_try_lock run_lock(run_mutex_);
+  if (!run_lock.owns_lock())
+    return false;
+
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    function_ = &function;
+    count_ = count;
+    grain_ = grain ? grain : 1;
+    next_.store(0);
+    busy_workers_ = num_threads_;
+    ++generation_;
+  }
+  work_condition_.notify_all();
+
+  try
+  {
+    runChunks();
+  }
+  catch (...)
+  {
+    // Stop handing out chunks and let the workers drop function before it goes out of scope
+    next_.store(count);
+    waitForWorkers();
+    throw;
+  }
+
+  std::exception_ptr worker_error = waitForWorkers();
+  if (worker_error)
+    std::rethrow_exception(worker_error);
+  return true;
+}
+
+std::exception_ptr WorkerPool::waitForWorkers()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  while (busy_workers_ > 0)
+    done_condition_.wait(lock);
+  function_ = NULL;
+  std::exception_ptr error;
+  std::swap(error, worker_error_);
+  return error;
+}
+
+void WorkerPool::runChunks()
+{
+  std::size_t begin;
+  while ((begin = next_.fetch_add(grain_)) < count_)
+  {
+    std::size_t end = std::min(begin + grain_, count_);
+    (*function_)(begin, end);
+  }
+}
+
+void WorkerPool::workerThread()
+{
+  uint64_t seen_generation = 0;
+  while (true)
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!shutdown_ && generation_ == seen_generation)
+        work_condition_.wait(lock);
+      if (shutdown_)
+        return;
+      seen_generation = generation_;
+    }
+
+    try
+    {
+      runChunks();
+    }
+    catch (...)
+    {
+      // Stop handing out chunks, the first exception is rethrown on the calling thread
+      next_.store(count_);
+      boost::mutex::scoped_lock lock(mutex_);
+      if (!worker_error_)
+        worker_error_ = std::current_exception();
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    if (--busy_workers_ == 0)
+      done_condition_.notify_one();
+  }
+}
+
+}
@@ -0,0 +1,104 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef TF2_WORKER_POOL_H
+#define TF2_WORKER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace tf2
+{
+
+/** \brief A fixed set of threads which split index ranges between them.
+ *
+ * parallelFor hands out chunks of the range from a shared atomic cursor, so a thread which finishes
+ * its chunks early keeps taking more while slower threads are still busy. The calling thread works
+ * on the range too. Only one range runs at a time; a call made while the pool is busy, including one
+ * made from inside a running chunk, returns false without running anything so that the caller can
+ * fall back to doing the work itself. An exception thrown by function stops the remaining chunks from
+ * being handed out and is rethrown on the calling thread once the workers are idle again; when
+ * several are thrown, one thrown on the calling thread wins, otherwise the first one from a worker.
+ */
+class WorkerPool
+{
+public:
+  typedef boost::function<void(std::size_t begin, std::size_t end)> RangeFunction;
+
+  explicit WorkerPool(unsigned int num_threads);
+  ~WorkerPool();
+
+  unsigned int size() const { return num_threads_; }
+
+  /** \brief Call function on chunks of at most grain indices until [0, count) is covered
+   * \return False if the pool was busy and nothing was run
+   */
+  bool parallelFor(std::size_t count, std::size_t grain, const RangeFunction& function);
+
+private:
+  void workerThread();
+  void runChunks();
+  /// Returns the exception a worker caught, if any
+  std::exception_ptr waitForWorkers();
+
+  unsigned int num_threads_;
+  boost::thread_group threads_;
+
+  /// Held for the whole duration of a parallelFor call
+  boost::mutex run_mutex_;
+
+  boost::mutex mutex_;
+  boost::condition_variable work_condition_;
+  boost::condition_variable done_condition_;
+  uint64_t generation_;
+  unsigned int busy_workers_;
+  bool shutdown_;
+
+  const RangeFunction* function_;
+  std::size_t count_;
+  std::size_t grain_;
+  std::atomic<std::size_t> next_;
+  std::exception_ptr worker_error_;
+};
+
+}
+
+#endif // TF2_WORKER_POOL_H
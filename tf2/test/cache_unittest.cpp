@@ -407,6 +407,146 @@ TEST(TimeCache, DuplicateEntries)
   EXPECT_TRUE(!std::isnan(stor.rotation_.w()));
 }
 
+TEST(TimeCache, ClearAfter)
+{
+  TimeCache cache;
+
+  TransformStorage stor;
+  setIdentity(stor);
+  stor.frame_id_ = 3;
+  for (int i = 1; i <= 10; i++)
+  {
+    stor.stamp_ = ros::Time().fromSec(i);
+    cache.insertData(stor);
+  }
+
+  cache.clearAfter(ros::Time().fromSec(4.5));
+  EXPECT_EQ(cache.getListLength(), 4);
+  EXPECT_EQ(cache.getLatestTimestamp(), ros::Time().fromSec(4));
+  EXPECT_EQ(cache.getOldestTimestamp(), ros::Time().fromSec(1));
+
+  // Data after the jump point can be inserted again
+  stor.stamp_ = ros::Time().fromSec(5);
+  EXPECT_TRUE(cache.insertData(stor));
+
+  cache.clearAfter(ros::Time());
+  EXPECT_EQ(cache.getListLength(), 0);
+}
+
+TEST(CompactTimeCache, Size)
+{
+  EXPECT_LE(sizeof(CompactTransformStorage) * 2, sizeof(TransformStorage) + 8);
+}
+
+TEST(CompactTimeCache, AccuracyBounds)
+{
+  // The bounds documented for CompactTransformStorage
+  seed_rand();
+  CompactTimeCache cache;
+
+  TransformStorage stor;
+  stor.frame_id_ = 3;
+  for (int i = 1; i <= 100; i++)
+  {
+    stor.translation_.setValue(4000.0 * get_rand(), 4000.0 * get_rand(), 10.0 * get_rand());
+    stor.rotation_.setRPY(M_PI * get_rand(), M_PI * get_rand(), M_PI * get_rand());
+    stor.stamp_ = ros::Time().fromSec(i);
+    ASSERT_TRUE(cache.insertData(stor));
+
+    TransformStorage out;
+    ASSERT_TRUE(cache.getData(stor.stamp_, out));
+    EXPECT_NEAR(stor.translation_.x(), out.translation_.x(), 0.25e-3);
+    EXPECT_NEAR(stor.translation_.y(), out.translation_.y(), 0.25e-3);
+    EXPECT_NEAR(stor.translation_.z(), out.translation_.z(), 1e-6);
+    EXPECT_LT(stor.rotation_.angleShortestPath(out.rotation_), 1e-7);
+    EXPECT_NEAR(1.0, out.rotation_.length2(), 1e-12);
+    EXPECT_EQ(stor.frame_id_, out.frame_id_);
+  }
+}
+
+TEST(CompactTimeCache, MatchesTimeCache)
+{
+  seed_rand();
+  TimeCache cache;
+  CompactTimeCache compact_cache;
+
+  TransformStorage stor;
+  stor.frame_id_ = 3;
+  // Insert out of order to exercise the late data path as well
+  for (int i = 10; i >= 1; i--)
+  {
+    stor.translation_.setValue(10.0 * get_rand(), 10.0 * get_rand(), 10.0 * get_rand());
+    stor.rotation_.setRPY(M_PI * get_rand(), M_PI * get_rand(), M_PI * get_rand());
+    stor.stamp_ = ros::Time().fromSec(i);
+    EXPECT_TRUE(cache.insertData(stor));
+    EXPECT_TRUE(compact_cache.insertData(stor));
+  }
+  EXPECT_FALSE(compact_cache.insertData(stor));
+  EXPECT_EQ(cache.getListLength(), compact_cache.getListLength());
+  EXPECT_EQ(cache.getOldestTimestamp(), compact_cache.getOldestTimestamp());
+  EXPECT_EQ(cache.getLatestTimestamp(), compact_cache.getLatestTimestamp());
+
+  for (double t = 1.0; t <= 10.0; t += 0.25)
+  {
+    TransformStorage out, compact_out;
+    ASSERT_TRUE(cache.getData(ros::Time(t), out));
+    ASSERT_TRUE(compact_cache.getData(ros::Time(t), compact_out));
+    EXPECT_EQ(out.stamp_, compact_out.stamp_);
+    EXPECT_LT(out.translation_.distance(compact_out.translation_), 1e-5);
+    EXPECT_LT(out.rotation_.angleShortestPath(compact_out.rotation_), 1e-6);
+  }
+
+  TransformStorage out;
+  EXPECT_FALSE(compact_cache.getData(ros::Time(11), out));
+  compact_cache.clearAfter(ros::Time(5));
+  EXPECT_EQ(5, compact_cache.getListLength());
+}
+
+/** \brief A cache written against the interface before clearAfter and getDataSince were added */
+class SingleSampleCache : public TimeCacheInterface
+{
+public:
+  SingleSampleCache() : has_data_(false) {}
+  virtual bool getData(ros::Time time, TransformStorage & data_out, std::string* error_str = 0)
+  {
+    data_out = data_;
+    return has_data_;
+  }
+  virtual bool insertData(const TransformStorage& new_data, std::string* error_str = 0)
+  {
+    data_ = new_data;
+    has_data_ = true;
+    return true;
+  }
+  virtual void clearList() { has_data_ = false; }
+  virtual CompactFrameID getParent(ros::Time time, std::string* error_str) { return has_data_ ? data_.frame_id_ : 0; }
+  virtual P_TimeAndFrameID getLatestTimeAndParent() { return std::make_pair(data_.stamp_, getParent(data_.stamp_, 0)); }
+  virtual unsigned int getListLength() { return has_data_ ? 1 : 0; }
+  virtual ros::Time getLatestTimestamp() { return data_.stamp_; }
+  virtual ros::Time getOldestTimestamp() { return data_.stamp_; }
+
+private:
+  TransformStorage data_;
+  bool has_data_;
+};
+
+TEST(TimeCacheInterface, Defaults)
+{
+  SingleSampleCache cache;
+  TransformStorage stor;
+  setIdentity(stor);
+  stor.frame_id_ = 1;
+  stor.stamp_ = ros::Time(2);
+  cache.insertData(stor);
+
+  std::vector<TransformStorage> since;
+  cache.getDataSince(ros::Time(), since);
+  EXPECT_TRUE(since.empty());
+
+  cache.clearAfter(ros::Time(1));
+  EXPECT_EQ(0u, cache.getListLength());
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,150 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <gtest/gtest.h>
+#include <tf2/frame_registry.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <sstream>
+
+using namespace tf2;
+
+static std::string frameName(unsigned int i)
+{
+  std::stringstream ss;
+  ss << "frame_" << i;
+  return ss.str();
+}
+
+TEST(FrameRegistry, InsertAndLookup)
+{
+  FrameRegistry registry;
+  EXPECT_EQ(0u, registry.size());
+  EXPECT_EQ(0u, registry.lookupOrInsert("NO_PARENT"));
+  EXPECT_EQ(1u, registry.lookupOrInsert("map"));
+  EXPECT_EQ(2u, registry.lookupOrInsert("odom"));
+  EXPECT_EQ(1u, registry.lookupOrInsert("map"));
+  EXPECT_EQ(3u, registry.size());
+
+  EXPECT_EQ(2u, registry.lookup("odom"));
+  EXPECT_EQ(0u, registry.lookup("base_link"));
+
+  CompactFrameID id = 42;
+  EXPECT_TRUE(registry.find("NO_PARENT", id));
+  EXPECT_EQ(0u, id);
+  EXPECT_FALSE(registry.find("base_link", id));
+
+  ASSERT_TRUE(registry.lookupString(1));
+  EXPECT_EQ("map", *registry.lookupString(1));
+  EXPECT_FALSE(registry.lookupString(3));
+}
+
+TEST(FrameRegistry, Growth)
+{
+  // Spans several segments and table resizes
+  const unsigned int count = 5000;
+  FrameRegistry registry;
+  const std::string* first = NULL;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    EXPECT_EQ(i, registry.lookupOrInsert(frameName(i)));
+    if (i == 0)
+      first = registry.lookupString(0);
+  }
+
+  // Names never move once published
+  EXPECT_EQ(first, registry.lookupString(0));
+  EXPECT_EQ(count, registry.size());
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    EXPECT_EQ(i, registry.lookup(frameName(i)));
+    EXPECT_EQ(frameName(i), *registry.lookupString(i));
+  }
+}
+
+static void insertFrames(FrameRegistry* registry, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; ++i)
+    registry->lookupOrInsert(frameName(i));
+}
+
+static void readFrames(FrameRegistry* registry, unsigned int count, bool* ok)
+{
+  *ok = true;
+  while (registry->size() < count)
+  {
+    CompactFrameID size = registry->size();
+    for (CompactFrameID id = 0; id < size; ++id)
+    {
+      const std::string* name = registry->lookupString(id);
+      CompactFrameID found = 0;
+      if (!name || !registry->find(*name, found) || found != id)
+      {
+        // A published name is resolvable in both directions
+        *ok = false;
+        return;
+      }
+    }
+  }
+}
+
+TEST(FrameRegistry, ConcurrentReaders)
+{
+  const unsigned int count = 2000;
+  FrameRegistry registry;
+  bool ok[4];
+  boost::thread_group readers;
+  for (unsigned int i = 0; i < 4; ++i)
+    readers.create_thread(boost::bind(&readFrames, &registry, count, &ok[i]));
+
+  boost::thread_group writers;
+  for (unsigned int i = 0; i < 2; ++i)
+    writers.create_thread(boost::bind(&insertFrames, &registry, count));
+  writers.join_all();
+  readers.join_all();
+
+  EXPECT_EQ(count, registry.size());
+  for (unsigned int i = 0; i < 4; ++i)
+    EXPECT_TRUE(ok[i]);
+  for (unsigned int i = 0; i < count; ++i)
+    EXPECT_EQ(frameName(i), *registry.lookupString(registry.lookup(frameName(i))));
+}
+
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
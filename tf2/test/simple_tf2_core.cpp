@@ -30,8 +30,16 @@
 #include <gtest/gtest.h>
 #include <tf2/buffer_core.h>
 #include <ros/time.h>
+#include <atomic>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include "tf2/LinearMath/Vector3.h"
 #include "tf2/exceptions.h"
+#include "tf2_msgs/TF2Error.h"
 
 TEST(tf2, setTransformFail)
 {
@@ -65,6 +73,801 @@ TEST(tf2, setTransformInvalidQuaternion)
 
 }
 
+TEST(tf2, setTransformNonFinite)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.header.frame_id = "foo";
+  st.header.stamp = ros::Time(1.0);
+  st.child_frame_id = "child";
+  st.transform.rotation.w = 1;
+
+  st.transform.translation.x = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+  st.transform.translation.x = -std::numeric_limits<double>::infinity();
+  EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+  st.transform.translation.x = 0;
+  st.transform.rotation.z = std::numeric_limits<double>::infinity();
+  EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+  st.transform.rotation.z = 0;
+  st.transform.rotation.w = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+  EXPECT_FALSE(tfc._frameExists("child"));
+
+  // Leading slashes are still stripped on the fast path
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "/foo";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_TRUE(tfc.canTransform("foo", "child", ros::Time(1.0)));
+}
+
+TEST(tf2, setTransformRejectedFlood)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.header.frame_id = "foo";
+  st.header.stamp = ros::Time(100.0);
+  st.child_frame_id = "child";
+  st.transform.rotation.w = 1;
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // Repeated and old data keep being rejected while the warnings are rate limited
+  for (int i = 0; i < 1000; ++i)
+  {
+    EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+    st.header.stamp = ros::Time(1.0);
+    EXPECT_FALSE(tfc.setTransform(st, "authority2"));
+    st.header.stamp = ros::Time(100.0);
+  }
+
+  st.header.stamp = ros::Time(101.0);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // Counted per authority, with only the first rejection of each warned about
+  std::vector<tf2::RejectedDataCount> counts;
+  tfc.getRejectedDataCounts(counts);
+  ASSERT_EQ(2, counts.size());
+  EXPECT_EQ("child", counts[0].child_frame_id);
+  EXPECT_EQ("authority1", counts[0].authority);
+  EXPECT_EQ(1000, counts[0].rejected);
+  EXPECT_EQ(1, counts[0].reported);
+  EXPECT_EQ("child", counts[1].child_frame_id);
+  EXPECT_EQ("authority2", counts[1].authority);
+  EXPECT_EQ(1000, counts[1].rejected);
+  EXPECT_EQ(1, counts[1].reported);
+
+  tfc.clear();
+  tfc.getRejectedDataCounts(counts);
+  EXPECT_TRUE(counts.empty());
+}
+
+TEST(tf2, setTransformRejectsLoop)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.stamp = ros::Time(1);
+  st.header.frame_id = "a";
+  st.child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  st.header.frame_id = "b";
+  st.child_frame_id = "c";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // c is a descendant of a
+  st.header.frame_id = "c";
+  st.child_frame_id = "a";
+  EXPECT_FALSE(tfc.setTransform(st, "authority1"));
+  EXPECT_NO_THROW(tfc.lookupTransform("a", "c", ros::Time(1)));
+
+  // Moving a frame to another branch is fine
+  st.header.stamp = ros::Time(2);
+  st.header.frame_id = "x";
+  st.child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // a under b only forms a loop at time 1, where b was still under a
+  st.header.stamp = ros::Time(1);
+  st.header.frame_id = "b";
+  st.child_frame_id = "a";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  std::string error;
+  EXPECT_FALSE(tfc.canTransform("x", "c", ros::Time(1), &error));
+  EXPECT_NE(std::string::npos, error.find("loop")) << error;
+  EXPECT_THROW(tfc.lookupTransform("x", "c", ros::Time(1)), tf2::LookupException);
+}
+
+TEST(tf2, rejectedStaticLoopLeavesNoFrame)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.stamp = ros::Time(1);
+  st.header.frame_id = "a";
+  st.child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // The first data of a is rejected, so a gets no cache
+  st.header.frame_id = "b";
+  st.child_frame_id = "a";
+  EXPECT_FALSE(tfc.setTransform(st, "authority1", true));
+
+  std::vector<tf2_msgs::FrameHistory> history;
+  tfc.getFrameHistory(std::vector<std::string>(), ros::Duration(), history);
+  ASSERT_EQ(1u, history.size());
+  EXPECT_EQ("b", history[0].child_frame_id);
+  EXPECT_EQ("a", tfc.lookupTransform("a", "b", ros::Time(1)).header.frame_id);
+}
+
+TEST(tf2, setTransformsReparentInOneMessage)
+{
+  tf2::BufferCore tfc;
+  std::vector<geometry_msgs::TransformStamped> transforms(2);
+  for (size_t i = 0; i < transforms.size(); ++i)
+  {
+    transforms[i].header.stamp = ros::Time(1);
+    transforms[i].transform.rotation.w = 1;
+  }
+  transforms[0].header.frame_id = "root";
+  transforms[0].child_frame_id = "a";
+  transforms[1].header.frame_id = "a";
+  transforms[1].child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransforms(transforms, "authority1"));
+
+  // a and b swap places; a only stops closing a loop once b has moved, which comes later in the message
+  transforms[0].header.stamp = ros::Time(2);
+  transforms[0].header.frame_id = "b";
+  transforms[0].child_frame_id = "a";
+  transforms[1].header.stamp = ros::Time(2);
+  transforms[1].header.frame_id = "root";
+  transforms[1].child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransforms(transforms, "authority1"));
+  EXPECT_NO_THROW(tfc.lookupTransform("root", "a", ros::Time(2)));
+  EXPECT_NO_THROW(tfc.lookupTransform("root", "a", ros::Time(1)));
+
+  // A loop within the message itself is still rejected
+  transforms[0].header.stamp = ros::Time(3);
+  transforms[0].header.frame_id = "a";
+  transforms[0].child_frame_id = "root";
+  transforms[1].header.stamp = ros::Time(3);
+  transforms[1].header.frame_id = "b";
+  transforms[1].child_frame_id = "c";
+  EXPECT_FALSE(tfc.setTransforms(transforms, "authority1"));
+  EXPECT_NO_THROW(tfc.lookupTransform("b", "c", ros::Time(3)));
+  std::string error;
+  EXPECT_FALSE(tfc.canTransform("a", "root", ros::Time(3), &error));
+
+  // Late data for an older stamp is not checked against the current tree
+  geometry_msgs::TransformStamped st = transforms[0];
+  st.header.stamp = ros::Time(1.5);
+  st.header.frame_id = "a";
+  st.child_frame_id = "b";
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+}
+
+TEST(tf2, setTransforms)
+{
+  tf2::BufferCore tfc;
+  std::vector<geometry_msgs::TransformStamped> transforms(3);
+  for (size_t i = 0; i < transforms.size(); ++i)
+  {
+    transforms[i].header.stamp = ros::Time(1);
+    transforms[i].transform.rotation.w = 1;
+  }
+  transforms[0].header.frame_id = "a";
+  transforms[0].child_frame_id = "b";
+  transforms[1].header.frame_id = "b";
+  transforms[1].child_frame_id = "c";
+  // Invalid entries are skipped without losing the rest of the batch
+  transforms[2].header.frame_id = "c";
+  transforms[2].child_frame_id = "c";
+
+  EXPECT_FALSE(tfc.setTransforms(transforms, "authority1"));
+  EXPECT_TRUE(tfc.canTransform("a", "c", ros::Time(1)));
+  EXPECT_FALSE(tfc._frameExists("d"));
+
+  transforms.pop_back();
+  transforms[0].header.stamp = ros::Time(2);
+  transforms[1].header.stamp = ros::Time(2);
+  EXPECT_TRUE(tfc.setTransforms(transforms, "authority1"));
+  EXPECT_TRUE(tfc.canTransform("a", "c", ros::Time(1.5)));
+  EXPECT_TRUE(tfc.setTransforms(std::vector<geometry_msgs::TransformStamped>(), "authority1"));
+}
+
+TEST(tf2, setCompactStorage)
+{
+  tf2::BufferCore tfc;
+  tfc.setCompactStorage(true);
+  EXPECT_TRUE(tfc.isCompactStorage());
+
+  geometry_msgs::TransformStamped st;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.transform.translation.x = 1234.5678;
+  st.transform.rotation.w = 1;
+  st.header.stamp = ros::Time(1);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  st.transform.translation.x = 1235.5678;
+  st.header.stamp = ros::Time(2);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  geometry_msgs::TransformStamped out = tfc.lookupTransform("map", "base_link", ros::Time(1.5));
+  EXPECT_NEAR(1235.0678, out.transform.translation.x, 1e-4);
+  EXPECT_DOUBLE_EQ(1.0, out.transform.rotation.w);
+}
+
+/** Stands in for a writer, holding the frame mutex of the buffer until released */
+static void holdFrameMutex(tf2::BufferCore* tfc, std::atomic<bool>* locked, const std::atomic<bool>* release)
+{
+  tf2::TestBufferCore tester;
+  boost::timed_mutex::scoped_lock lock(tester._frameMutex(*tfc));
+  *locked = true;
+  while (!*release)
+    ros::WallDuration(0.001).sleep();
+}
+
+TEST(tf2, tryLookupTransformBusy)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.header.stamp = ros::Time(1);
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.transform.translation.x = 1.0;
+  st.transform.rotation.w = 1;
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  tf2::LookupContext context;
+  geometry_msgs::TransformStamped out;
+  EXPECT_EQ(tf2_msgs::TF2Error::NO_ERROR, tfc.tryLookupTransform("map", "base_link", ros::Time(), ros::WallDuration(), out, context));
+  EXPECT_DOUBLE_EQ(1.0, out.transform.translation.x);
+  EXPECT_EQ(tf2_msgs::TF2Error::LOOKUP_ERROR, tfc.tryLookupTransform("map", "missing", ros::Time(), ros::WallDuration(), out, context));
+  EXPECT_FALSE(context.getErrorString().empty());
+  EXPECT_EQ(tf2_msgs::TF2Error::EXTRAPOLATION_ERROR, tfc.tryLookupTransform("map", "base_link", ros::Time(2), ros::WallDuration(), out, context));
+
+  // While a writer holds the buffer the lookup gives up after max_wait
+  std::atomic<bool> locked(false), release(false);
+  boost::thread writer(boost::bind(&holdFrameMutex, &tfc, &locked, &release));
+  while (!locked)
+    ros::WallDuration(0.001).sleep();
+  ros::WallTime start = ros::WallTime::now();
+  EXPECT_EQ(tf2::BufferCore::LOOKUP_BUSY, tfc.tryLookupTransform("map", "base_link", ros::Time(), ros::WallDuration(0.01), out, context));
+  double waited = (ros::WallTime::now() - start).toSec();
+  EXPECT_GE(waited, 0.009);
+  EXPECT_LT(waited, 1.0);
+  EXPECT_EQ(tf2::BufferCore::LOOKUP_BUSY, tfc.tryLookupTransform("map", "map", ros::Time(), ros::WallDuration(), out, context));
+  release = true;
+  writer.join();
+
+  EXPECT_EQ(tf2_msgs::TF2Error::NO_ERROR, tfc.tryLookupTransform("map", "base_link", ros::Time(), ros::WallDuration(), out, context));
+}
+
+static void insertTransforms(tf2::BufferCore* tfc, const std::atomic<bool>* done)
+{
+  std::vector<geometry_msgs::TransformStamped> transforms(100);
+  for (size_t i = 0; i < transforms.size(); ++i)
+  {
+    std::stringstream ss;
+    ss << "link" << i;
+    transforms[i].header.frame_id = i ? transforms[i - 1].child_frame_id : "map";
+    transforms[i].child_frame_id = ss.str();
+    transforms[i].transform.rotation.w = 1;
+  }
+  for (unsigned int stamp = 1; !*done; ++stamp)
+  {
+    for (size_t i = 0; i < transforms.size(); ++i)
+      transforms[i].header.stamp = ros::Time(stamp * 0.001);
+    tfc->setTransforms(transforms, "authority1");
+  }
+}
+
+TEST(tf2, tryLookupTransformLatencyUnderLoad)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.header.stamp = ros::Time(0.001);
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.transform.rotation.w = 1;
+  EXPECT_TRUE(tfc.setTransform(st, "authority1", true));
+
+  std::atomic<bool> done(false);
+  boost::thread inserter(boost::bind(&insertTransforms, &tfc, &done));
+
+  const ros::WallDuration max_wait(0.001);
+  tf2::LookupContext context;
+  geometry_msgs::TransformStamped out;
+  unsigned int succeeded = 0, busy = 0;
+  double worst = 0.0;
+  ros::WallTime end = ros::WallTime::now() + ros::WallDuration(0.5);
+  while (ros::WallTime::now() < end)
+  {
+    ros::WallTime start = ros::WallTime::now();
+    int result = tfc.tryLookupTransform("map", "base_link", ros::Time(), max_wait, out, context);
+    worst = std::max(worst, (ros::WallTime::now() - start).toSec());
+    if (result == tf2_msgs::TF2Error::NO_ERROR)
+      ++succeeded;
+    else if (result == tf2::BufferCore::LOOKUP_BUSY)
+      ++busy;
+    else
+      ADD_FAILURE() << context.getErrorString();
+  }
+  done = true;
+  inserter.join();
+
+  RecordProperty("worst_case_latency_us", (int)(worst * 1e6));
+  RecordProperty("busy_lookups", (int)busy);
+  EXPECT_GT(succeeded, 0u);
+  // The bound itself is checked in tryLookupTransformBusy, preemption by the inserter can add a
+  // scheduler time slice or two here
+  EXPECT_LT(worst, max_wait.toSec() + 0.1);
+}
+
+TEST(tf2, frameHistory)
+{
+  tf2::BufferCore source;
+  geometry_msgs::TransformStamped st;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.transform.rotation.w = 1;
+  for (int i = 1; i <= 10; ++i)
+  {
+    st.header.stamp = ros::Time(i);
+    st.transform.translation.x = i;
+    // The parent changes half way, which is sent once per parent
+    if (i == 6)
+      st.header.frame_id = "odom";
+    EXPECT_TRUE(source.setTransform(st, "authority1"));
+  }
+  st.header.frame_id = "map";
+  st.child_frame_id = "odom";
+  st.header.stamp = ros::Time(1);
+  st.transform.translation.x = 0;
+  EXPECT_TRUE(source.setTransform(st, "authority1", true));
+
+  std::vector<tf2_msgs::FrameHistory> history;
+  source.getFrameHistory(std::vector<std::string>(1, "base_link"), ros::Duration(3.0), history);
+  ASSERT_EQ(1u, history.size());
+  EXPECT_EQ("base_link", history[0].child_frame_id);
+  EXPECT_FALSE(history[0].is_static);
+  ASSERT_EQ(4u, history[0].stamps.size());
+  EXPECT_EQ(ros::Time(7), history[0].stamps[0]);
+  EXPECT_EQ(ros::Time(10), history[0].stamps[3]);
+  ASSERT_EQ(1u, history[0].parent_frame_ids.size());
+  EXPECT_EQ("odom", history[0].parent_frame_ids[0]);
+  EXPECT_DOUBLE_EQ(7.0, history[0].transforms[0].translation.x);
+
+  source.getFrameHistory(std::vector<std::string>(), ros::Duration(), history);
+  ASSERT_EQ(2u, history.size());
+  EXPECT_EQ(2u, history[0].parent_frame_ids.size());
+  EXPECT_TRUE(history[1].is_static);
+
+  // A new buffer answers lookups into the past right away
+  tf2::BufferCore target;
+  EXPECT_TRUE(target.setFrameHistory(history, "history"));
+  EXPECT_NEAR(2.5, target.lookupTransform("map", "base_link", ros::Time(2.5)).transform.translation.x, 1e-6);
+  EXPECT_NEAR(8.5, target.lookupTransform("map", "base_link", ros::Time(8.5)).transform.translation.x, 1e-6);
+
+  // A buffer which already received the newest samples live keeps them and takes the older ones
+  tf2::BufferCore live;
+  st.header.frame_id = "odom";
+  st.child_frame_id = "base_link";
+  st.transform.translation.x = 100;
+  for (int i = 9; i <= 11; ++i)
+  {
+    st.header.stamp = ros::Time(i);
+    EXPECT_TRUE(live.setTransform(st, "authority1"));
+  }
+  EXPECT_TRUE(live.setFrameHistory(history, "history"));
+  EXPECT_NEAR(2.5, live.lookupTransform("map", "base_link", ros::Time(2.5)).transform.translation.x, 1e-6);
+  EXPECT_NEAR(100.0, live.lookupTransform("odom", "base_link", ros::Time(10)).transform.translation.x, 1e-6);
+
+  history[0].parents[0] = 5;
+  EXPECT_FALSE(target.setFrameHistory(history, "history"));
+}
+
+TEST(tf2, setCacheLength)
+{
+  tf2::BufferCore tfc(ros::Duration(1.0));
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "odom";
+  st.header.stamp = ros::Time(1);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // Applies to the frame which already exists
+  tfc.setCacheLength(ros::Duration(10.0));
+  EXPECT_EQ(ros::Duration(10.0), tfc.getCacheLength());
+  st.header.stamp = ros::Time(5);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_TRUE(tfc.canTransform("map", "odom", ros::Time(2)));
+
+  tfc.setCacheLength(ros::Duration(1.0));
+  st.header.stamp = ros::Time(6);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_FALSE(tfc.canTransform("map", "odom", ros::Time(2)));
+  EXPECT_TRUE(tfc.canTransform("map", "odom", ros::Time(5.5)));
+}
+
+TEST(tf2, lookupTransformContext)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "odom";
+  st.transform.translation.x = 1;
+  for (int i = 1; i <= 2; i++)
+  {
+    st.header.stamp = ros::Time(i);
+    EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  }
+  st.header.frame_id = "odom";
+  st.child_frame_id = "base_link";
+  st.transform.translation.x = 0;
+  st.transform.translation.y = 2;
+  for (int i = 1; i <= 2; i++)
+  {
+    st.header.stamp = ros::Time(i);
+    EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  }
+
+  tf2::LookupContext context;
+  geometry_msgs::TransformStamped out;
+  for (int i = 0; i < 3; i++)
+  {
+    tfc.lookupTransform("map", "base_link", ros::Time(), out, context);
+    geometry_msgs::TransformStamped expected = tfc.lookupTransform("map", "base_link", ros::Time());
+    EXPECT_EQ(expected.header.stamp, out.header.stamp);
+    EXPECT_EQ("map", out.header.frame_id);
+    EXPECT_EQ("base_link", out.child_frame_id);
+    EXPECT_DOUBLE_EQ(1.0, out.transform.translation.x);
+    EXPECT_DOUBLE_EQ(2.0, out.transform.translation.y);
+
+    tfc.lookupTransform("base_link", "map", ros::Time(1.5), out, context);
+    EXPECT_DOUBLE_EQ(-1.0, out.transform.translation.x);
+    EXPECT_DOUBLE_EQ(-2.0, out.transform.translation.y);
+  }
+
+  // The identity transform overwrites whatever the output held before
+  tfc.lookupTransform("odom", "odom", ros::Time(1), out, context);
+  EXPECT_DOUBLE_EQ(0.0, out.transform.translation.x);
+  EXPECT_DOUBLE_EQ(0.0, out.transform.translation.y);
+  EXPECT_DOUBLE_EQ(1.0, out.transform.rotation.w);
+
+  // A failed lookup leaves the context usable
+  EXPECT_THROW(tfc.lookupTransform("map", "base_link", ros::Time(5), out, context), tf2::ExtrapolationException);
+  tfc.lookupTransform("map", "base_link", ros::Time(1), out, context);
+  EXPECT_DOUBLE_EQ(2.0, out.transform.translation.y);
+
+  std::vector<std::string> chain;
+  tfc._chainAsVector("base_link", ros::Time(), "map", ros::Time(), "map", chain, context);
+  std::vector<std::string> expected_chain;
+  tfc._chainAsVector("base_link", ros::Time(), "map", ros::Time(), "map", expected_chain);
+  EXPECT_EQ(expected_chain, chain);
+  EXPECT_EQ(3u, chain.size());
+}
+
+TEST(tf2, lookupTransforms)
+{
+  tf2::BufferCore tfc;
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.z = std::sin(0.25);
+  st.transform.rotation.w = std::cos(0.25);
+  st.transform.translation.x = 1;
+  const char* edges[][2] = {{"map", "odom"}, {"odom", "base_link"}, {"base_link", "camera"}, {"base_link", "lidar"}, {"other", "unconnected"}};
+  for (int e = 0; e < 5; e++)
+  {
+    st.header.frame_id = edges[e][0];
+    st.child_frame_id = edges[e][1];
+    st.transform.translation.y = e;
+    // map -> odom stops early, so lookups below odom outlive it
+    for (int i = 1; i <= (e == 0 ? 2 : 4); i++)
+    {
+      st.header.stamp = ros::Time(i);
+      EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+    }
+  }
+
+  struct Query
+  {
+    const char* target;
+    const char* source;
+    double time;
+  } queries[] = {
+    {"map", "camera", 1.5}, {"map", "lidar", 1.5}, {"camera", "lidar", 1.5}, {"lidar", "map", 0.0},
+    {"odom", "camera", 3.0}, {"camera", "lidar", 3.5}, {"base_link", "odom", 0.0}, {"camera", "camera", 0.0},
+    {"map", "camera", 3.0}, {"map", "camera", 5.0}, {"map", "unconnected", 1.5}, {"map", "missing", 1.0},
+  };
+  const size_t count = sizeof(queries) / sizeof(queries[0]);
+
+  tf2::LookupBatch batch;
+  for (size_t i = 0; i < count; i++)
+  {
+    EXPECT_EQ(i, batch.add(queries[i].target, queries[i].source, ros::Time(queries[i].time)));
+  }
+  size_t fixed = batch.add("camera", ros::Time(2), "lidar", ros::Time(3), "odom");
+  size_t invalid = batch.add("/map", "camera", ros::Time(1));
+  ASSERT_EQ(count + 2, batch.size());
+
+  // Executing again reuses the batch
+  for (int run = 0; run < 2; run++)
+  {
+    tfc.lookupTransforms(batch);
+
+    for (size_t i = 0; i < count; i++)
+    {
+      SCOPED_TRACE(i);
+      geometry_msgs::TransformStamped expected;
+      try
+      {
+        expected = tfc.lookupTransform(queries[i].target, queries[i].source, ros::Time(queries[i].time));
+      }
+      catch (tf2::ExtrapolationException&)
+      {
+        EXPECT_EQ(tf2_msgs::TF2Error::EXTRAPOLATION_ERROR, batch.getError(i));
+        EXPECT_THROW(batch.getTransform(i), tf2::ExtrapolationException);
+        continue;
+      }
+      catch (tf2::ConnectivityException&)
+      {
+        EXPECT_EQ(tf2_msgs::TF2Error::CONNECTIVITY_ERROR, batch.getError(i));
+        EXPECT_THROW(batch.getTransform(i), tf2::ConnectivityException);
+        continue;
+      }
+      catch (tf2::LookupException&)
+      {
+        EXPECT_EQ(tf2_msgs::TF2Error::LOOKUP_ERROR, batch.getError(i));
+        EXPECT_THROW(batch.getTransform(i), tf2::LookupException);
+        continue;
+      }
+
+      ASSERT_EQ(tf2_msgs::TF2Error::NO_ERROR, batch.getError(i)) << batch.getErrorString(i);
+      EXPECT_TRUE(batch.getErrorString(i).empty());
+      const geometry_msgs::TransformStamped& out = batch.getTransform(i);
+      EXPECT_EQ(expected.header.stamp, out.header.stamp);
+      EXPECT_EQ(expected.header.frame_id, out.header.frame_id);
+      EXPECT_EQ(expected.child_frame_id, out.child_frame_id);
+      EXPECT_NEAR(expected.transform.translation.x, out.transform.translation.x, 1e-9);
+      EXPECT_NEAR(expected.transform.translation.y, out.transform.translation.y, 1e-9);
+      EXPECT_NEAR(expected.transform.translation.z, out.transform.translation.z, 1e-9);
+      EXPECT_NEAR(expected.transform.rotation.z, out.transform.rotation.z, 1e-9);
+      EXPECT_NEAR(expected.transform.rotation.w, out.transform.rotation.w, 1e-9);
+    }
+
+    geometry_msgs::TransformStamped expected = tfc.lookupTransform("camera", ros::Time(2), "lidar", ros::Time(3), "odom");
+    const geometry_msgs::TransformStamped& out = batch.getTransform(fixed);
+    EXPECT_EQ(expected.header.stamp, out.header.stamp);
+    EXPECT_NEAR(expected.transform.translation.x, out.transform.translation.x, 1e-9);
+    EXPECT_NEAR(expected.transform.translation.y, out.transform.translation.y, 1e-9);
+    EXPECT_NEAR(expected.transform.rotation.z, out.transform.rotation.z, 1e-9);
+
+    EXPECT_EQ(tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR, batch.getError(invalid));
+    EXPECT_THROW(batch.getTransform(invalid), tf2::InvalidArgumentException);
+  }
+
+  batch.clear();
+  EXPECT_EQ(0u, batch.size());
+}
+
+struct TransformableCounter
+{
+  TransformableCounter() : available(0), failed(0), timed_out(0) {}
+
+  void callback(tf2::TransformableRequestHandle request_handle, const std::string& target_frame, const std::string& source_frame,
+                ros::Time time, tf2::TransformableResult result)
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    if (target_frame != "map" || source_frame != "base_link")
+      return;
+    handles.push_back(request_handle);
+    if (result == tf2::TransformAvailable)
+      ++available;
+    else if (result == tf2::TransformTimeout)
+      ++timed_out;
+    else
+      ++failed;
+  }
+
+  int timedOut()
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    return timed_out;
+  }
+
+  boost::mutex mutex;
+  std::vector<tf2::TransformableRequestHandle> handles;
+  int available;
+  int failed;
+  int timed_out;
+};
+
+TEST(tf2, setTransformableRequestWorkers)
+{
+  tf2::BufferCore tfc(ros::Duration(10));
+  EXPECT_EQ(0u, tfc.getTransformableRequestWorkers());
+  tfc.setTransformableRequestWorkers(3, 16);
+  EXPECT_EQ(3u, tfc.getTransformableRequestWorkers());
+
+  TransformableCounter counter;
+  tf2::TransformableCallbackHandle cb_handle = tfc.addTransformableCallback(
+    boost::bind(&TransformableCounter::callback, &counter, _1, _2, _3, _4, _5));
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.header.stamp = ros::Time(20);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // Requests past the data wait, requests older than the cache fail once newer data arrives
+  const int count = 1000;
+  std::vector<tf2::TransformableRequestHandle> requests;
+  for (int i = 0; i < count; i++)
+  {
+    ros::Time time = (i % 4 == 0) ? ros::Time(35 + i * 0.001) : ros::Time(21 + i * 0.001);
+    tf2::TransformableRequestHandle handle = tfc.addTransformableRequest(cb_handle, "map", "base_link", time);
+    ASSERT_NE(0u, handle);
+    requests.push_back(handle);
+  }
+  EXPECT_TRUE(counter.handles.empty());
+
+  st.header.stamp = ros::Time(30);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(count * 3 / 4, counter.available);
+  EXPECT_EQ(0, counter.failed);
+
+  st.header.stamp = ros::Time(50);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(count * 3 / 4, counter.available);
+  EXPECT_EQ(count / 4, counter.failed);
+
+  // Every request was answered exactly once
+  std::sort(counter.handles.begin(), counter.handles.end());
+  std::sort(requests.begin(), requests.end());
+  EXPECT_EQ(requests, counter.handles);
+
+  tfc.setTransformableRequestWorkers(0);
+  EXPECT_EQ(0u, tfc.getTransformableRequestWorkers());
+  tfc.removeTransformableCallback(cb_handle);
+}
+
+void throwOffThread(boost::thread::id caller, tf2::TransformableRequestHandle, const std::string&, const std::string&,
+                    ros::Time, tf2::TransformableResult)
+{
+  if (boost::this_thread::get_id() != caller)
+    throw std::runtime_error("callback failed");
+  // Leave the workers some of the callbacks
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+}
+
+TEST(tf2, transformableCallbackThrowsOnWorker)
+{
+  tf2::BufferCore tfc(ros::Duration(10));
+  tfc.setTransformableRequestWorkers(3, 16);
+  tf2::TransformableCallbackHandle cb_handle = tfc.addTransformableCallback(
+    boost::bind(&throwOffThread, boost::this_thread::get_id(), _1, _2, _3, _4, _5));
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.header.stamp = ros::Time(20);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_NE(0u, tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(21 + i * 0.01)));
+  }
+
+  // The exception from a worker reaches the inserting thread like one from a serial dispatch
+  st.header.stamp = ros::Time(30);
+  EXPECT_THROW(tfc.setTransform(st, "authority1"), std::runtime_error);
+
+  // and the pool still runs the next batch
+  TransformableCounter counter;
+  tf2::TransformableCallbackHandle counter_handle = tfc.addTransformableCallback(
+    boost::bind(&TransformableCounter::callback, &counter, _1, _2, _3, _4, _5));
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_NE(0u, tfc.addTransformableRequest(counter_handle, "map", "base_link", ros::Time(31 + i * 0.01)));
+  }
+  st.header.stamp = ros::Time(40);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(100, counter.available);
+  tfc.removeTransformableCallback(counter_handle);
+  tfc.removeTransformableCallback(cb_handle);
+}
+
+TEST(tf2, transformableRequestTimeout)
+{
+  tf2::BufferCore tfc;
+  TransformableCounter counter;
+  tf2::TransformableCallbackHandle cb_handle = tfc.addTransformableCallback(
+    boost::bind(&TransformableCounter::callback, &counter, _1, _2, _3, _4, _5));
+
+  // Neither frame exists yet
+  tf2::TransformableRequestHandle expiring = tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(10), ros::WallDuration(0.05));
+  tf2::TransformableRequestHandle cancelled = tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(11), ros::WallDuration(0.05));
+  tf2::TransformableRequestHandle answered = tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(1), ros::WallDuration(0.05));
+  tf2::TransformableRequestHandle waiting = tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(12));
+  ASSERT_NE(0u, expiring);
+  ASSERT_NE(0u, cancelled);
+  ASSERT_NE(0u, answered);
+  ASSERT_NE(0u, waiting);
+  tfc.cancelTransformableRequest(cancelled);
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.header.stamp = ros::Time(1);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(1, counter.available);
+
+  ros::WallTime end = ros::WallTime::now() + ros::WallDuration(5.0);
+  while (counter.timedOut() < 1 && ros::WallTime::now() < end)
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+  boost::mutex::scoped_lock lock(counter.mutex);
+  EXPECT_EQ(1, counter.timed_out);
+  EXPECT_EQ(1, counter.available);
+  EXPECT_EQ(0, counter.failed);
+  ASSERT_EQ(2u, counter.handles.size());
+  EXPECT_EQ(answered, counter.handles[0]);
+  EXPECT_EQ(expiring, counter.handles[1]);
+  lock.unlock();
+
+  // The request without a timeout is still pending
+  st.header.stamp = ros::Time(12);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(2, counter.available);
+  tfc.removeTransformableCallback(cb_handle);
+}
+
+TEST(tf2, transformableIntervalRequest)
+{
+  tf2::BufferCore tfc;
+  TransformableCounter counter;
+  tf2::TransformableCallbackHandle cb_handle = tfc.addTransformableCallback(
+    boost::bind(&TransformableCounter::callback, &counter, _1, _2, _3, _4, _5));
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "map";
+  st.child_frame_id = "base_link";
+  st.header.stamp = ros::Time(1);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+
+  // Only the start of the interval is covered
+  tf2::TransformableRequestHandle interval = tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(1), ros::Time(3));
+  ASSERT_NE(0u, interval);
+  ASSERT_NE(0xffffffffffffffffULL, interval);
+  EXPECT_EQ(0u, tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(1), ros::Time(1)));
+
+  st.header.stamp = ros::Time(2);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(0, counter.available);
+
+  st.header.stamp = ros::Time(3);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(1, counter.available);
+  ASSERT_EQ(1u, counter.handles.size());
+  EXPECT_EQ(interval, counter.handles[0]);
+
+  // Now covered as a whole
+  EXPECT_EQ(0u, tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(1), ros::Time(3)));
+
+  // The start fell out of the cache, so it can never be transformable
+  st.header.stamp = ros::Time(30);
+  EXPECT_TRUE(tfc.setTransform(st, "authority1"));
+  EXPECT_EQ(0xffffffffffffffffULL, tfc.addTransformableRequest(cb_handle, "map", "base_link", ros::Time(2), ros::Time(31)));
+  tfc.removeTransformableCallback(cb_handle);
+}
+
 TEST(tf2_lookupTransform, LookupException_Nothing_Exists)
 {
   tf2::BufferCore tfc;
@@ -312,6 +1115,76 @@ TEST(tf2_walkToTopParent, walk_v_configuration)
   if( id_chain.size() >= 2 ) EXPECT_EQ("d", tBC._lookupFrameString(mBC, id_chain[1]));
 }
 
+TEST(tf2_allFramesAsFrameInfo, frame_info)
+{
+  tf2::BufferCore mBC;
+  std::vector<tf2_msgs::FrameInfo> frames;
+  mBC.allFramesAsFrameInfo(frames);
+  EXPECT_EQ(0, frames.size());
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.frame_id = "a";
+  st.child_frame_id = "b";
+  for (int i = 0; i < 5; ++i)
+  {
+    st.header.stamp = ros::Time(10, 123456789) + ros::Duration(0.5 * i);
+    mBC.setTransform(st, "authority1");
+  }
+
+  st.header.stamp = ros::Time(0);
+  st.header.frame_id = "b";
+  st.child_frame_id = "c";
+  mBC.setTransform(st, "authority2", true);
+
+  mBC.allFramesAsFrameInfo(frames);
+  ASSERT_EQ(2, frames.size());
+
+  EXPECT_EQ("b", frames[0].frame_id);
+  EXPECT_EQ("a", frames[0].parent_id);
+  EXPECT_EQ("authority1", frames[0].authority);
+  EXPECT_EQ(ros::Time(12, 123456789), frames[0].most_recent_transform);
+  EXPECT_EQ(ros::Time(10, 123456789), frames[0].oldest_transform);
+  EXPECT_EQ(ros::Duration(2.0), frames[0].buffer_length);
+  EXPECT_EQ(5, frames[0].buffer_size);
+  EXPECT_NEAR(2.5, frames[0].rate, 1e-9);
+  EXPECT_FALSE(frames[0].is_static);
+
+  EXPECT_EQ("c", frames[1].frame_id);
+  EXPECT_EQ("b", frames[1].parent_id);
+  EXPECT_EQ("authority2", frames[1].authority);
+  EXPECT_TRUE(frames[1].is_static);
+}
+TEST(tf2_clearAfter, keeps_static_and_older_data)
+{
+  tf2::BufferCore mBC;
+
+  geometry_msgs::TransformStamped st;
+  st.transform.rotation.w = 1;
+  st.header.stamp = ros::Time(0);
+  st.header.frame_id = "a";
+  st.child_frame_id = "b";
+  mBC.setTransform(st, "authority1", true);
+
+  st.header.frame_id = "b";
+  st.child_frame_id = "c";
+  for (int i = 1; i <= 10; ++i)
+  {
+    st.header.stamp = ros::Time(i);
+    mBC.setTransform(st, "authority1");
+  }
+
+  mBC.clearAfter(ros::Time(5));
+  EXPECT_TRUE(mBC.canTransform("a", "b", ros::Time(8)));
+  EXPECT_TRUE(mBC.canTransform("a", "c", ros::Time(3)));
+  EXPECT_FALSE(mBC.canTransform("a", "c", ros::Time(8)));
+  EXPECT_EQ(ros::Time(5), mBC.lookupTransform("a", "c", ros::Time()).header.stamp);
+
+  // New data from before the old latest time is accepted again after the jump
+  st.header.stamp = ros::Time(6);
+  EXPECT_TRUE(mBC.setTransform(st, "authority1"));
+  EXPECT_TRUE(mBC.canTransform("a", "c", ros::Time(5.5)));
+}
 
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
@@ -32,7 +32,72 @@
 #include <ros/time.h>
 #include <console_bridge/console.h>
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+void insertBenchmark(const char* name, const std::vector<ros::Time>& stamps)
+{
+  tf2::BufferCore bc;
+  geometry_msgs::TransformStamped t;
+  t.header.frame_id = "root";
+  t.child_frame_id = "child";
+  t.transform.rotation.w = 1.0;
+
+  ros::WallTime start = ros::WallTime::now();
+  for (size_t i = 0; i < stamps.size(); ++i)
+  {
+    t.header.stamp = stamps[i];
+    bc.setTransform(t, "me");
+  }
+  ros::WallTime end = ros::WallTime::now();
+  ros::WallDuration dur = end - start;
+  CONSOLE_BRIDGE_logInform("setTransform %s took %f for an average of %.9f", name, dur.toSec(), dur.toSec() / (double)stamps.size());
+}
+
+void countTransformable(uint32_t* counter, tf2::TransformableRequestHandle, const std::string&, const std::string&,
+                        ros::Time, tf2::TransformableResult)
+{
+  __sync_fetch_and_add(counter, 1);
+}
+
+/** Recovery of a backlog of requests along a 10 level chain, which all become transformable with one insertion */
+void backlogBenchmark(unsigned int workers)
+{
+  tf2::BufferCore bc;
+  bc.setTransformableRequestWorkers(workers);
+  geometry_msgs::TransformStamped t;
+  t.transform.rotation.w = 1.0;
+  for (uint32_t i = 0; i < 10; ++i)
+  {
+    t.header.frame_id = i ? boost::lexical_cast<std::string>(i - 1) : "root";
+    t.child_frame_id = boost::lexical_cast<std::string>(i);
+    t.header.stamp = ros::Time(1);
+    bc.setTransform(t, "me");
+  }
+
+  uint32_t counter = 0;
+  tf2::TransformableCallbackHandle cb_handle = bc.addTransformableCallback(boost::bind(&countTransformable, &counter, _1, _2, _3, _4, _5));
+  const uint32_t request_count = 20000;
+  for (uint32_t i = 0; i < request_count; ++i)
+  {
+    bc.addTransformableRequest(cb_handle, "root", "9", ros::Time(1) + ros::Duration(0.5 * i / request_count));
+  }
+
+  // Nothing becomes transformable until the last link of the chain catches up
+  ros::WallTime start = ros::WallTime::now();
+  for (uint32_t i = 0; i < 10; ++i)
+  {
+    t.header.frame_id = i ? boost::lexical_cast<std::string>(i - 1) : "root";
+    t.child_frame_id = boost::lexical_cast<std::string>(i);
+    t.header.stamp = ros::Time(2);
+    bc.setTransform(t, "me");
+  }
+  ros::WallDuration dur = ros::WallTime::now() - start;
+  CONSOLE_BRIDGE_logInform("Recovering a backlog of %u requests with %u workers took %f, %u callbacks", request_count, workers, dur.toSec(), counter);
+}
 
 int main(int argc, char** argv)
 {
@@ -167,6 +232,75 @@ int main(int argc, char** argv)
   }
 #endif
 
+#if 01
+  {
+    tf2::LookupContext context;
+    ros::WallTime start = ros::WallTime::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      bc.lookupTransform(v_frame1, v_frame0, ros::Time(0), out_t, context);
+    }
+    ros::WallTime end = ros::WallTime::now();
+    ros::WallDuration dur = end - start;
+    CONSOLE_BRIDGE_logInform("lookupTransform with context at Time(0) took %f for an average of %.9f", dur.toSec(), dur.toSec() / (double)count);
+  }
+#endif
+
+#if 01
+  {
+    tf2::LookupContext context;
+    ros::WallTime start = ros::WallTime::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      bc.lookupTransform(v_frame1, v_frame0, ros::Time(1.5), out_t, context);
+    }
+    ros::WallTime end = ros::WallTime::now();
+    ros::WallDuration dur = end - start;
+    CONSOLE_BRIDGE_logInform("lookupTransform with context at Time(1.5) took %f for an average of %.9f", dur.toSec(), dur.toSec() / (double)count);
+  }
+#endif
+
+#if 01
+  {
+    // A cycle of lookups from every frame of one branch, which share most of their chains
+    std::vector<std::string> sources;
+    for (uint32_t i = num_levels / 2; i < num_levels; ++i)
+    {
+      sources.push_back(boost::lexical_cast<std::string>(i));
+    }
+    const uint32_t cycles = count / sources.size();
+
+    tf2::LookupContext context;
+    ros::WallTime start = ros::WallTime::now();
+    for (uint32_t i = 0; i < cycles; ++i)
+    {
+      for (size_t j = 0; j < sources.size(); ++j)
+      {
+        bc.lookupTransform(v_frame1, sources[j], ros::Time(1.5), out_t, context);
+      }
+    }
+    ros::WallTime end = ros::WallTime::now();
+    ros::WallDuration dur = end - start;
+    CONSOLE_BRIDGE_logInform("lookupTransform of %u cycles of %u at Time(1.5) took %f for an average of %.9f",
+                             cycles, (uint32_t)sources.size(), dur.toSec(), dur.toSec() / (double)(cycles * sources.size()));
+
+    tf2::LookupBatch batch;
+    for (size_t j = 0; j < sources.size(); ++j)
+    {
+      batch.add(v_frame1, sources[j], ros::Time(1.5));
+    }
+    start = ros::WallTime::now();
+    for (uint32_t i = 0; i < cycles; ++i)
+    {
+      bc.lookupTransforms(batch);
+    }
+    end = ros::WallTime::now();
+    dur = end - start;
+    CONSOLE_BRIDGE_logInform("lookupTransforms of %u batches of %u at Time(1.5) took %f for an average of %.9f",
+                             cycles, (uint32_t)sources.size(), dur.toSec(), dur.toSec() / (double)(cycles * sources.size()));
+  }
+#endif
+
 #if 01
   {
     ros::WallTime start = ros::WallTime::now();
@@ -249,4 +383,81 @@ int main(int argc, char** argv)
     CONSOLE_BRIDGE_logInform("canTransform at Time(3) with error string took %f for an average of %.9f", dur.toSec(), dur.toSec() / (double)count);
   }
 #endif
+
+  // Insertion of a 1 kHz stream into a 10 s cache, in order and with late arriving samples
+  {
+    const uint32_t insert_count = 100000;
+    const ros::Time insert_start(100);
+    const ros::Duration period(0.001);
+    std::vector<ros::Time> stamps;
+    stamps.reserve(insert_count);
+
+    for (uint32_t i = 0; i < insert_count; ++i)
+    {
+      stamps.push_back(insert_start + period * i);
+    }
+    insertBenchmark("in order", stamps);
+
+    // Every block of 4 samples arrives newest first
+    stamps.clear();
+    for (uint32_t i = 0; i < insert_count; ++i)
+    {
+      stamps.push_back(insert_start + period * ((i & ~3U) + 3 - (i & 3U)));
+    }
+    insertBenchmark("slightly late", stamps);
+
+    // Every other sample comes from a publisher lagging 300 ms behind
+    stamps.clear();
+    for (uint32_t i = 0; i < insert_count; ++i)
+    {
+      if (i % 2)
+        stamps.push_back(insert_start + period * ((double)i - 300));
+      else
+        stamps.push_back(insert_start + period * i);
+    }
+    insertBenchmark("300 ms late", stamps);
+  }
+
+  // TFMessages with 20 transforms each, inserted one transform at a time and as a batch
+  {
+    const uint32_t message_count = 10000;
+    std::vector<geometry_msgs::TransformStamped> message(20);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+      message[i].header.frame_id = "root";
+      message[i].child_frame_id = boost::lexical_cast<std::string>(i);
+      message[i].transform.translation.x = 1;
+      message[i].transform.rotation.w = 1.0;
+    }
+
+    tf2::BufferCore single_bc;
+    ros::WallTime start = ros::WallTime::now();
+    for (uint32_t i = 0; i < message_count; ++i)
+    {
+      for (size_t j = 0; j < message.size(); ++j)
+      {
+        message[j].header.stamp = ros::Time(100) + ros::Duration(0.001) * i;
+        single_bc.setTransform(message[j], "me");
+      }
+    }
+    ros::WallDuration dur = ros::WallTime::now() - start;
+    CONSOLE_BRIDGE_logInform("setTransform of %u messages took %f for an average of %.9f per transform", message_count, dur.toSec(), dur.toSec() / (message_count * message.size()));
+
+    tf2::BufferCore batch_bc;
+    start = ros::WallTime::now();
+    for (uint32_t i = 0; i < message_count; ++i)
+    {
+      for (size_t j = 0; j < message.size(); ++j)
+        message[j].header.stamp = ros::Time(100) + ros::Duration(0.001) * i;
+      batch_bc.setTransforms(message, "me");
+    }
+    dur = ros::WallTime::now() - start;
+    CONSOLE_BRIDGE_logInform("setTransforms of %u messages took %f for an average of %.9f per transform", message_count, dur.toSec(), dur.toSec() / (message_count * message.size()));
+  }
+
+  backlogBenchmark(0);
+  if (boost::thread::hardware_concurrency() > 1)
+  {
+    backlogBenchmark(boost::thread::hardware_concurrency() - 1);
+  }
 }
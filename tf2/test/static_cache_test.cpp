@@ -95,6 +95,23 @@ TEST(StaticCache, DuplicateEntries)
   EXPECT_TRUE(!std::isnan(stor.rotation_.w()));
 }
 
+TEST(StaticCache, GetDataSinceEmpty)
+{
+  tf2::StaticCache cache;
+  std::vector<TransformStorage> data;
+  cache.getDataSince(ros::Time(), data);
+  EXPECT_TRUE(data.empty());
+  EXPECT_EQ(0u, cache.getLatestTimeAndParent().second);
+
+  TransformStorage stor;
+  setIdentity(stor);
+  stor.frame_id_ = CompactFrameID(3);
+  cache.insertData(stor);
+  cache.getDataSince(ros::Time(), data);
+  ASSERT_EQ(1u, data.size());
+  EXPECT_EQ(CompactFrameID(3), data[0].frame_id_);
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -94,6 +94,59 @@ class GeometryMsgs(unittest.TestCase):
         self.assertEqual(out.wrench.torque.y, 0)
         self.assertEqual(out.wrench.torque.z, 0)
 
+    def test_native_transform(self):
+        # 90 deg about z, then 1 along x
+        t = TransformStamped()
+        t.header.stamp = rospy.Time(2)
+        t.header.frame_id = 'a'
+        t.child_frame_id = 'b'
+        t.transform.translation.x = 1
+        t.transform.rotation.z = 0.5 ** 0.5
+        t.transform.rotation.w = 0.5 ** 0.5
+
+        p = PointStamped()
+        p.point.x = 1
+        out = tf2_geometry_msgs.do_transform_point(p, t)
+        self.assertEqual(out.header.frame_id, 'a')
+        self.assertAlmostEqual(out.point.x, 1)
+        self.assertAlmostEqual(out.point.y, 1)
+        self.assertAlmostEqual(out.point.z, 0)
+
+        v = Vector3Stamped()
+        v.vector.x = 1
+        out = tf2_geometry_msgs.do_transform_vector3(v, t)
+        self.assertAlmostEqual(out.vector.x, 0)
+        self.assertAlmostEqual(out.vector.y, 1)
+
+        pose = PoseStamped()
+        pose.pose.position.y = 1
+        pose.pose.orientation.w = 1
+        out = tf2_geometry_msgs.do_transform_pose(pose, t)
+        self.assertAlmostEqual(out.pose.position.x, 0)
+        self.assertAlmostEqual(out.pose.position.y, 0)
+        self.assertAlmostEqual(out.pose.orientation.z, 0.5 ** 0.5)
+        self.assertAlmostEqual(out.pose.orientation.w, 0.5 ** 0.5)
+
+    def test_native_transform_errors(self):
+        t = TransformStamped()
+        t.transform.rotation.w = 1
+
+        # Messages of the wrong type raise instead of crashing the interpreter
+        self.assertRaises(AttributeError, tf2_geometry_msgs.do_transform_point, Vector3Stamped(), t)
+        self.assertRaises(AttributeError, tf2_geometry_msgs.do_transform_vector3, PointStamped(), t)
+        self.assertRaises(AttributeError, tf2_geometry_msgs.do_transform_pose, PointStamped(), t)
+        self.assertRaises(AttributeError, tf2_geometry_msgs.do_transform_point, PointStamped(), PointStamped())
+
+        p = PointStamped()
+        p.point.x = 'one'
+        self.assertRaises(TypeError, tf2_geometry_msgs.do_transform_point, p, t)
+        v = Vector3Stamped()
+        v.vector.z = None
+        self.assertRaises(TypeError, tf2_geometry_msgs.do_transform_vector3, v, t)
+        pose = PoseStamped()
+        pose.pose.orientation.w = None
+        self.assertRaises(TypeError, tf2_geometry_msgs.do_transform_pose, pose, t)
+
 if __name__ == '__main__':
     import rosunit
     rospy.init_node('test_tf2_geometry_msgs_python')
@@ -31,7 +31,7 @@ from geometry_msgs.msg import PoseStamped, Vector3Stamped, PointStamped, WrenchS
 import PyKDL
 import rospy
 import tf2_ros
-import copy
+from tf2_py import do_transform_point, do_transform_vector3, do_transform_pose
 
 def to_msg_msg(msg):
     return msg
@@ -55,45 +55,9 @@ def transform_to_kdl(t):
                                     t.transform.translation.z))
 
 
-# PointStamped
-def do_transform_point(point, transform):
-    p = transform_to_kdl(transform) * PyKDL.Vector(point.point.x, point.point.y, point.point.z)
-    res = PointStamped()
-    res.point.x = p[0]
-    res.point.y = p[1]
-    res.point.z = p[2]
-    res.header = transform.header
-    return res
+# PointStamped, Vector3Stamped and PoseStamped are transformed natively by tf2_py
 tf2_ros.TransformRegistration().add(PointStamped, do_transform_point)
-
-
-# Vector3Stamped
-def do_transform_vector3(vector3, transform):
-    transform = copy.deepcopy(transform)
-    transform.transform.translation.x = 0;
-    transform.transform.translation.y = 0;
-    transform.transform.translation.z = 0;
-    p = transform_to_kdl(transform) * PyKDL.Vector(vector3.vector.x, vector3.vector.y, vector3.vector.z)
-    res = Vector3Stamped()
-    res.vector.x = p[0]
-    res.vector.y = p[1]
-    res.vector.z = p[2]
-    res.header = transform.header
-    return res
 tf2_ros.TransformRegistration().add(Vector3Stamped, do_transform_vector3)
-
-# PoseStamped
-def do_transform_pose(pose, transform):
-    f = transform_to_kdl(transform) * PyKDL.Frame(PyKDL.Rotation.Quaternion(pose.pose.orientation.x, pose.pose.orientation.y,
-                                                                          pose.pose.orientation.z, pose.pose.orientation.w),
-                                                PyKDL.Vector(pose.pose.position.x, pose.pose.position.y, pose.pose.position.z))
-    res = PoseStamped()
-    res.pose.position.x = f[(0, 3)]
-    res.pose.position.y = f[(1, 3)]
-    res.pose.position.z = f[(2, 3)]
-    (res.pose.orientation.x, res.pose.orientation.y, res.pose.orientation.z, res.pose.orientation.w) = f.M.GetQuaternion()
-    res.header = transform.header
-    return res
 tf2_ros.TransformRegistration().add(PoseStamped, do_transform_pose)
 
 # WrenchStamped
@@ -2,6 +2,9 @@
 
 #include <tf2/buffer_core.h>
 #include <tf2/exceptions.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_msgs/TFMessage.h>
+#include <ros/serialization.h>
 
 #include "python_compat.h"
 
@@ -203,6 +206,50 @@ static PyObject *allFramesAsYAML(PyObject *self, PyObject *args)
   return stringToPython(bc->allFramesAsYAML());
 }
 
+static PyObject *rostimeToPython(const ros::Time& time)
+{
+  PyObject *rospy_time = PyObject_GetAttrString(pModulerospy, "Time");
+  PyObject *args = Py_BuildValue("ii", time.sec, time.nsec);
+  PyObject *ob = PyObject_CallObject(rospy_time, args);
+  Py_DECREF(args);
+  Py_DECREF(rospy_time);
+  return ob;
+}
+
+static PyObject *rosdurationToPython(const ros::Duration& duration)
+{
+  PyObject *rospy_duration = PyObject_GetAttrString(pModulerospy, "Duration");
+  PyObject *args = Py_BuildValue("ii", duration.sec, duration.nsec);
+  PyObject *ob = PyObject_CallObject(rospy_duration, args);
+  Py_DECREF(args);
+  Py_DECREF(rospy_duration);
+  return ob;
+}
+
+static PyObject *allFramesAsFrameInfo(PyObject *self, PyObject *args)
+{
+  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
+  std::vector<tf2_msgs::FrameInfo> frames;
+  bc->allFramesAsFrameInfo(frames);
+
+  PyObject *r = PyList_New(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    const tf2_msgs::FrameInfo& info = frames[i];
+    // (frame_id, parent_id, authority, rate, most_recent_transform, oldest_transform, buffer_length, buffer_size, is_static)
+    PyList_SetItem(r, i, Py_BuildValue("(NNNdNNNIO)",
+                                       stringToPython(info.frame_id),
+                                       stringToPython(info.parent_id),
+                                       stringToPython(info.authority),
+                                       info.rate,
+                                       rostimeToPython(info.most_recent_transform),
+                                       rostimeToPython(info.oldest_transform),
+                                       rosdurationToPython(info.buffer_length),
+                                       info.buffer_size,
+                                       info.is_static ? Py_True : Py_False));
+  }
+  return r;
+}
+
 static PyObject *allFramesAsString(PyObject *self, PyObject *args)
 {
   tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
@@ -419,44 +466,79 @@ static inline int checkRotationType(PyObject* o)
   return attr_check;
 }
 
-static PyObject *setTransform(PyObject *self, PyObject *args)
+// Read the float attribute name of o, false with the Python exception set if it is missing or not a number
+static bool floatFromPython(PyObject *o, const char *name, double& value)
 {
-  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
-  PyObject *py_transform;
-  char *authority;
-
-  if (!PyArg_ParseTuple(args, "Os", &py_transform, &authority))
-    return NULL;
+  PyObject *attr = PyObject_GetAttrString(o, name);
+  if (attr == NULL)
+    return false;
+  value = PyFloat_AsDouble(attr);
+  Py_DECREF(attr);
+  return !PyErr_Occurred();
+}
 
-  geometry_msgs::TransformStamped transform;
+static int transformFromPython(PyObject *py_transform, geometry_msgs::TransformStamped& transform)
+{
   PyObject *header = pythonBorrowAttrString(py_transform, "header");
-  transform.child_frame_id = stringFromPython(pythonBorrowAttrString(py_transform, "child_frame_id"));
-  transform.header.frame_id = stringFromPython(pythonBorrowAttrString(header, "frame_id"));
-  if (rostime_converter(pythonBorrowAttrString(header, "stamp"), &transform.header.stamp) != 1)
-    return NULL;
+  if (header == NULL)
+    return 0;
+  PyObject *child_frame_id = pythonBorrowAttrString(py_transform, "child_frame_id");
+  if (child_frame_id == NULL)
+    return 0;
+  transform.child_frame_id = stringFromPython(child_frame_id);
+  PyObject *frame_id = pythonBorrowAttrString(header, "frame_id");
+  if (frame_id == NULL)
+    return 0;
+  transform.header.frame_id = stringFromPython(frame_id);
+  PyObject *stamp = pythonBorrowAttrString(header, "stamp");
+  if (stamp == NULL || rostime_converter(stamp, &transform.header.stamp) != 1)
+    return 0;
 
   PyObject *mtransform = pythonBorrowAttrString(py_transform, "transform");
+  if (mtransform == NULL)
+    return 0;
 
   PyObject *translation = pythonBorrowAttrString(mtransform, "translation");
+  if (translation == NULL)
+    return 0;
   if (!checkTranslationType(translation)) {
     PyErr_SetString(PyExc_TypeError, "transform.translation must have members x, y, z");
-    return NULL;
+    return 0;
   }
 
-  transform.transform.translation.x = PyFloat_AsDouble(pythonBorrowAttrString(translation, "x"));
-  transform.transform.translation.y = PyFloat_AsDouble(pythonBorrowAttrString(translation, "y"));
-  transform.transform.translation.z = PyFloat_AsDouble(pythonBorrowAttrString(translation, "z"));
+  if (!floatFromPython(translation, "x", transform.transform.translation.x) ||
+      !floatFromPython(translation, "y", transform.transform.translation.y) ||
+      !floatFromPython(translation, "z", transform.transform.translation.z))
+    return 0;
 
   PyObject *rotation = pythonBorrowAttrString(mtransform, "rotation");
+  if (rotation == NULL)
+    return 0;
   if (!checkRotationType(rotation)) {
     PyErr_SetString(PyExc_TypeError, "transform.rotation must have members w, x, y, z");
-    return NULL;
+    return 0;
   }
 
-  transform.transform.rotation.x = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "x"));
-  transform.transform.rotation.y = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "y"));
-  transform.transform.rotation.z = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "z"));
-  transform.transform.rotation.w = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "w"));
+  if (!floatFromPython(rotation, "x", transform.transform.rotation.x) ||
+      !floatFromPython(rotation, "y", transform.transform.rotation.y) ||
+      !floatFromPython(rotation, "z", transform.transform.rotation.z) ||
+      !floatFromPython(rotation, "w", transform.transform.rotation.w))
+    return 0;
+  return 1;
+}
+
+static PyObject *setTransform(PyObject *self, PyObject *args)
+{
+  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
+  PyObject *py_transform;
+  char *authority;
+
+  if (!PyArg_ParseTuple(args, "Os", &py_transform, &authority))
+    return NULL;
+
+  geometry_msgs::TransformStamped transform;
+  if (!transformFromPython(py_transform, transform))
+    return NULL;
 
   bc->setTransform(transform, authority);
   Py_RETURN_NONE;
@@ -472,36 +554,72 @@ static PyObject *setTransformStatic(PyObject *self, PyObject *args)
     return NULL;
 
   geometry_msgs::TransformStamped transform;
-  PyObject *header = pythonBorrowAttrString(py_transform, "header");
-  transform.child_frame_id = stringFromPython(pythonBorrowAttrString(py_transform, "child_frame_id"));
-  transform.header.frame_id = stringFromPython(pythonBorrowAttrString(header, "frame_id"));
-  if (rostime_converter(pythonBorrowAttrString(header, "stamp"), &transform.header.stamp) != 1)
+  if (!transformFromPython(py_transform, transform))
     return NULL;
 
-  PyObject *mtransform = pythonBorrowAttrString(py_transform, "transform");
-  PyObject *translation = pythonBorrowAttrString(mtransform, "translation");
-  if (!checkTranslationType(translation)) {
-    PyErr_SetString(PyExc_TypeError, "transform.translation must be of type Vector3");
+  // only difference to above is is_static == True
+  bc->setTransform(transform, authority, true);
+  Py_RETURN_NONE;
+}
+
+static PyObject *setTransforms(PyObject *self, PyObject *args, PyObject *kw)
+{
+  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
+  static const char *keywords[] = { "transforms", "authority", "is_static", NULL };
+  PyObject *py_transforms;
+  char *authority;
+  int is_static = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kw, "Os|i", (char**)keywords, &py_transforms, &authority, &is_static))
     return NULL;
+
+  PyObject *seq = PySequence_Fast(py_transforms, "transforms must be a sequence");
+  if (seq == NULL)
+    return NULL;
+
+  Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+  std::vector<geometry_msgs::TransformStamped> transforms(size);
+  for (Py_ssize_t i = 0; i < size; ++i)
+  {
+    if (!transformFromPython(PySequence_Fast_GET_ITEM(seq, i), transforms[i]))
+    {
+      Py_DECREF(seq);
+      return NULL;
+    }
   }
+  Py_DECREF(seq);
 
-  transform.transform.translation.x = PyFloat_AsDouble(pythonBorrowAttrString(translation, "x"));
-  transform.transform.translation.y = PyFloat_AsDouble(pythonBorrowAttrString(translation, "y"));
-  transform.transform.translation.z = PyFloat_AsDouble(pythonBorrowAttrString(translation, "z"));
+  bc->setTransforms(transforms, authority, is_static != 0);
+  Py_RETURN_NONE;
+}
 
-  PyObject *rotation = pythonBorrowAttrString(mtransform, "rotation");
-  if (!checkRotationType(rotation)) {
-    PyErr_SetString(PyExc_TypeError, "transform.rotation must be of type Quaternion");
+static PyObject *setTransformsSerialized(PyObject *self, PyObject *args, PyObject *kw)
+{
+  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
+  static const char *keywords[] = { "data", "authority", "is_static", NULL };
+  Py_buffer data;
+  char *authority;
+  int is_static = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kw, "s*s|i", (char**)keywords, &data, &authority, &is_static))
     return NULL;
-  }
 
-  transform.transform.rotation.x = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "x"));
-  transform.transform.rotation.y = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "y"));
-  transform.transform.rotation.z = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "z"));
-  transform.transform.rotation.w = PyFloat_AsDouble(pythonBorrowAttrString(rotation, "w"));
+  // Deserialize the raw tf2_msgs/TFMessage wire data directly, without building python message objects
+  tf2_msgs::TFMessage msg;
+  try
+  {
+    ros::serialization::IStream stream((uint8_t*)data.buf, (uint32_t)data.len);
+    ros::serialization::deserialize(stream, msg);
+  }
+  catch (const ros::Exception &e)
+  {
+    PyBuffer_Release(&data);
+    PyErr_SetString(PyExc_ValueError, e.what());
+    return NULL;
+  }
+  PyBuffer_Release(&data);
 
-  // only difference to above is is_static == True
-  bc->setTransform(transform, authority, true);
+  bc->setTransforms(msg.transforms, authority, is_static != 0);
   Py_RETURN_NONE;
 }
 
@@ -512,6 +630,16 @@ static PyObject *clear(PyObject *self, PyObject *args)
   Py_RETURN_NONE;
 }
 
+static PyObject *clearAfter(PyObject *self, PyObject *args)
+{
+  tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
+  ros::Time time;
+  if (!PyArg_ParseTuple(args, "O&", rostime_converter, &time))
+    return NULL;
+  bc->clearAfter(time);
+  Py_RETURN_NONE;
+}
+
 static PyObject *_frameExists(PyObject *self, PyObject *args)
 {
   tf2::BufferCore *bc = ((buffer_core_t*)self)->bc;
@@ -540,16 +668,209 @@ static PyObject *_allFramesAsDot(PyObject *self, PyObject *args, PyObject *kw)
 }
 
 
+/*
+ * Native implementations of the do_transform functions registered by tf2_geometry_msgs
+ * and tf2_sensor_msgs, so transforming python messages does not go through PyKDL.
+ */
+
+static int transformFromPythonMath(PyObject *py_transform, tf2::Transform& t)
+{
+  geometry_msgs::TransformStamped transform;
+  if (!transformFromPython(py_transform, transform))
+    return 0;
+  tf2::Quaternion q(transform.transform.rotation.x, transform.transform.rotation.y,
+                    transform.transform.rotation.z, transform.transform.rotation.w);
+  t.setRotation(q.normalize());
+  t.setOrigin(tf2::Vector3(transform.transform.translation.x, transform.transform.translation.y,
+                           transform.transform.translation.z));
+  return 1;
+}
+
+// Read the x, y and z attributes of o, false with the Python exception set if one is missing or not a number
+static bool vector3FromPython(PyObject *o, tf2::Vector3& v)
+{
+  double x, y, z;
+  if (o == NULL || !floatFromPython(o, "x", x) || !floatFromPython(o, "y", y) || !floatFromPython(o, "z", z))
+    return false;
+  v.setValue(x, y, z);
+  return true;
+}
+
+static void setFloatAttr(PyObject *o, const char *name, double value)
+{
+  PyObject *v = PyFloat_FromDouble(value);
+  PyObject_SetAttrString(o, name, v);
+  Py_DECREF(v);
+}
+
+static void vector3ToPython(const tf2::Vector3& v, PyObject *o)
+{
+  setFloatAttr(o, "x", v.x());
+  setFloatAttr(o, "y", v.y());
+  setFloatAttr(o, "z", v.z());
+}
+
+// Create an empty geometry_msgs message, stamped with the header of the transform
+static PyObject *stampedGeometryMsg(const char *type, PyObject *py_transform)
+{
+  PyObject *pclass = PyObject_GetAttrString(pModulegeometrymsgs, type);
+  if (pclass == NULL)
+    return NULL;
+  PyObject *pinst = PyObject_CallObject(pclass, NULL);
+  Py_DECREF(pclass);
+  if (pinst == NULL)
+    return NULL;
+  PyObject_SetAttrString(pinst, "header", pythonBorrowAttrString(py_transform, "header"));
+  return pinst;
+}
+
+static PyObject *doTransformPoint(PyObject *self, PyObject *args)
+{
+  PyObject *py_point, *py_transform;
+  tf2::Transform t;
+  if (!PyArg_ParseTuple(args, "OO", &py_point, &py_transform) || !transformFromPythonMath(py_transform, t))
+    return NULL;
+
+  tf2::Vector3 p;
+  if (!vector3FromPython(pythonBorrowAttrString(py_point, "point"), p))
+    return NULL;
+  p = t * p;
+  PyObject *res = stampedGeometryMsg("PointStamped", py_transform);
+  if (res == NULL)
+    return NULL;
+  vector3ToPython(p, pythonBorrowAttrString(res, "point"));
+  return res;
+}
+
+static PyObject *doTransformVector3(PyObject *self, PyObject *args)
+{
+  PyObject *py_vector, *py_transform;
+  tf2::Transform t;
+  if (!PyArg_ParseTuple(args, "OO", &py_vector, &py_transform) || !transformFromPythonMath(py_transform, t))
+    return NULL;
+
+  // Vectors are only rotated
+  tf2::Vector3 v;
+  if (!vector3FromPython(pythonBorrowAttrString(py_vector, "vector"), v))
+    return NULL;
+  v = t.getBasis() * v;
+  PyObject *res = stampedGeometryMsg("Vector3Stamped", py_transform);
+  if (res == NULL)
+    return NULL;
+  vector3ToPython(v, pythonBorrowAttrString(res, "vector"));
+  return res;
+}
+
+static PyObject *doTransformPose(PyObject *self, PyObject *args)
+{
+  PyObject *py_pose, *py_transform;
+  tf2::Transform t;
+  if (!PyArg_ParseTuple(args, "OO", &py_pose, &py_transform) || !transformFromPythonMath(py_transform, t))
+    return NULL;
+
+  PyObject *pose = pythonBorrowAttrString(py_pose, "pose");
+  if (pose == NULL)
+    return NULL;
+  PyObject *orientation = pythonBorrowAttrString(pose, "orientation");
+  double qx, qy, qz, qw;
+  if (orientation == NULL || !floatFromPython(orientation, "x", qx) || !floatFromPython(orientation, "y", qy) ||
+      !floatFromPython(orientation, "z", qz) || !floatFromPython(orientation, "w", qw))
+    return NULL;
+  tf2::Vector3 position;
+  if (!vector3FromPython(pythonBorrowAttrString(pose, "position"), position))
+    return NULL;
+  tf2::Quaternion q(qx, qy, qz, qw);
+  tf2::Transform out = t * tf2::Transform(q.normalize(), position);
+
+  PyObject *res = stampedGeometryMsg("PoseStamped", py_transform);
+  if (res == NULL)
+    return NULL;
+  PyObject *res_pose = pythonBorrowAttrString(res, "pose");
+  vector3ToPython(out.getOrigin(), pythonBorrowAttrString(res_pose, "position"));
+  tf2::Quaternion res_q = out.getRotation();
+  PyObject *res_orientation = pythonBorrowAttrString(res_pose, "orientation");
+  setFloatAttr(res_orientation, "x", res_q.x());
+  setFloatAttr(res_orientation, "y", res_q.y());
+  setFloatAttr(res_orientation, "z", res_q.z());
+  setFloatAttr(res_orientation, "w", res_q.w());
+  return res;
+}
+
+static PyObject *doTransformCloudData(PyObject *self, PyObject *args)
+{
+  PyObject *py_cloud, *py_transform;
+  unsigned int x_offset, y_offset, z_offset;
+  tf2::Transform t;
+  if (!PyArg_ParseTuple(args, "O(III)O", &py_cloud, &x_offset, &y_offset, &z_offset, &py_transform) ||
+      !transformFromPythonMath(py_transform, t))
+    return NULL;
+
+  unsigned long width = PyLong_AsUnsignedLong(pythonBorrowAttrString(py_cloud, "width"));
+  unsigned long height = PyLong_AsUnsignedLong(pythonBorrowAttrString(py_cloud, "height"));
+  unsigned long point_step = PyLong_AsUnsignedLong(pythonBorrowAttrString(py_cloud, "point_step"));
+  unsigned long row_step = PyLong_AsUnsignedLong(pythonBorrowAttrString(py_cloud, "row_step"));
+  if (PyErr_Occurred())
+    return NULL;
+
+  PyObject *py_data = pythonBorrowAttrString(py_cloud, "data");
+  Py_buffer data;
+  if (py_data == NULL || PyObject_GetBuffer(py_data, &data, PyBUF_SIMPLE) != 0)
+    return NULL;
+
+  unsigned int max_offset = std::max(x_offset, std::max(y_offset, z_offset));
+  if (height > 0 && width > 0 &&
+      ((height - 1) * row_step + (width - 1) * point_step + max_offset + sizeof(float) > (unsigned long)data.len ||
+       max_offset + sizeof(float) > point_step))
+  {
+    PyBuffer_Release(&data);
+    PyErr_SetString(PyExc_ValueError, "cloud data is smaller than described by its fields and dimensions");
+    return NULL;
+  }
+
+  // Copy the cloud once, then rewrite the xyz floats in place
+  PyObject *res = PyBytes_FromStringAndSize((const char*)data.buf, data.len);
+  PyBuffer_Release(&data);
+  if (res == NULL)
+    return NULL;
+
+  const tf2::Matrix3x3& basis = t.getBasis();
+  const tf2::Vector3& origin = t.getOrigin();
+  char *out = PyBytes_AS_STRING(res);
+  for (unsigned long row = 0; row < height; ++row)
+  {
+    char *point = out + row * row_step;
+    for (unsigned long col = 0; col < width; ++col, point += point_step)
+    {
+      float x, y, z;
+      memcpy(&x, point + x_offset, sizeof(float));
+      memcpy(&y, point + y_offset, sizeof(float));
+      memcpy(&z, point + z_offset, sizeof(float));
+      tf2::Vector3 p = basis * tf2::Vector3(x, y, z) + origin;
+      x = p.x();
+      y = p.y();
+      z = p.z();
+      memcpy(point + x_offset, &x, sizeof(float));
+      memcpy(point + y_offset, &y, sizeof(float));
+      memcpy(point + z_offset, &z, sizeof(float));
+    }
+  }
+  return res;
+}
+
 static struct PyMethodDef buffer_core_methods[] =
 {
   {"all_frames_as_yaml", allFramesAsYAML, METH_VARARGS},
   {"all_frames_as_string", allFramesAsString, METH_VARARGS},
+  {"all_frames_as_frame_info", allFramesAsFrameInfo, METH_VARARGS},
   {"set_transform", setTransform, METH_VARARGS},
   {"set_transform_static", setTransformStatic, METH_VARARGS},
+  {"set_transforms", (PyCFunction)setTransforms, METH_VARARGS | METH_KEYWORDS},
+  {"set_transforms_serialized", (PyCFunction)setTransformsSerialized, METH_VARARGS | METH_KEYWORDS},
   {"can_transform_core", (PyCFunction)canTransformCore, METH_VARARGS | METH_KEYWORDS},
   {"can_transform_full_core", (PyCFunction)canTransformFullCore, METH_VARARGS | METH_KEYWORDS},
   {"_chain", (PyCFunction)_chain, METH_VARARGS | METH_KEYWORDS},
   {"clear", (PyCFunction)clear, METH_VARARGS | METH_KEYWORDS},
+  {"clear_after", (PyCFunction)clearAfter, METH_VARARGS},
   {"_frameExists", (PyCFunction)_frameExists, METH_VARARGS},
   {"_getFrameStrings", (PyCFunction)_getFrameStrings, METH_VARARGS},
   {"_allFramesAsDot", (PyCFunction)_allFramesAsDot, METH_VARARGS | METH_KEYWORDS},
@@ -564,6 +885,10 @@ static struct PyMethodDef buffer_core_methods[] =
 
 static PyMethodDef module_methods[] = {
   // {"Transformer", mkTransformer, METH_VARARGS},
+  {"do_transform_point", doTransformPoint, METH_VARARGS},
+  {"do_transform_vector3", doTransformVector3, METH_VARARGS},
+  {"do_transform_pose", doTransformPose, METH_VARARGS},
+  {"do_transform_cloud_data", doTransformCloudData, METH_VARARGS},
   {0, 0, 0},
 };
 
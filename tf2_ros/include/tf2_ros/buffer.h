@@ -35,6 +35,7 @@
 #include <tf2_ros/buffer_interface.h>
 #include <tf2/buffer_core.h>
 #include <tf2_msgs/FrameGraph.h>
+#include <tf2_msgs/FrameInfoGraph.h>
 #include <ros/ros.h>
 #include <tf2/convert.h>
 
@@ -46,7 +47,8 @@ namespace tf2_ros
    *
    * Inherits tf2_ros::BufferInterface and tf2::BufferCore.
    * Stores known frames and optionally offers a ROS service, "tf2_frames", which responds to client requests
-   * with a response containing a tf2_msgs::FrameGraph representing the relationship of known frames.
+   * with a response containing a tf2_msgs::FrameGraph representing the relationship of known frames,
+   * and "tf2_frame_info", which responds with the same information as tf2_msgs::FrameInfo structures.
    */
   class Buffer: public BufferInterface, public tf2::BufferCore
   {
@@ -126,12 +128,14 @@ namespace tf2_ros
     
   private:
     bool getFrames(tf2_msgs::FrameGraph::Request& req, tf2_msgs::FrameGraph::Response& res) ;
+    bool getFrameInfo(tf2_msgs::FrameInfoGraph::Request& req, tf2_msgs::FrameInfoGraph::Response& res);
 
 
     // conditionally error if dedicated_thread unset.
     bool checkAndErrorDedicatedThreadPresent(std::string* errstr) const;
 
     ros::ServiceServer frames_server_;
+    ros::ServiceServer frame_info_server_;
 
 
   }; // class 
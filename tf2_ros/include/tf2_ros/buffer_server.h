@@ -39,6 +39,7 @@
 
 #include <actionlib/server/action_server.h>
 #include <tf2_msgs/LookupTransformAction.h>
+#include <tf2_msgs/TransformHistory.h>
 #include <geometry_msgs/TransformStamped.h>
 #include <tf2_ros/buffer.h>
 
@@ -48,6 +49,8 @@ namespace tf2_ros
    * 
    * Use this class with a tf2_ros::TransformListener in the same process.
    * You can use this class with a tf2_ros::BufferClient in a different process.
+   * The cached history of the buffer is also offered in bulk by the service <ns>/history, which
+   * tf2_ros::TransformListener::loadHistory uses to fill the buffer of a newly started node.
    */
   class BufferServer
   {
@@ -80,6 +83,7 @@ namespace tf2_ros
       void cancelCB(GoalHandle gh);
       void checkTransforms(const ros::TimerEvent& e);
       bool canTransform(GoalHandle gh);
+      bool historyCB(tf2_msgs::TransformHistory::Request& req, tf2_msgs::TransformHistory::Response& res);
       geometry_msgs::TransformStamped lookupTransform(GoalHandle gh);
 
       const Buffer& buffer_;
@@ -87,6 +91,7 @@ namespace tf2_ros
       std::list<GoalInfo> active_goals_;
       boost::mutex mutex_;
       ros::Timer check_timer_;
+      ros::ServiceServer history_service_;
   };
 }
 #endif
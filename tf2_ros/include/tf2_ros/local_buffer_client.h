@@ -0,0 +1,141 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#ifndef TF2_ROS_LOCAL_BUFFER_CLIENT_H_
+#define TF2_ROS_LOCAL_BUFFER_CLIENT_H_
+
+#include <tf2_ros/buffer_interface.h>
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+
+namespace tf2_ros
+{
+  /** \brief Client for a tf2_ros::LocalBufferServer running on the same host.
+   *
+   * Queries are sent over a Unix domain socket in a compact binary format, so this is a cheap
+   * replacement for a per-process TransformListener when a buffer server already ingests /tf.
+   * Blocking with a timeout happens on the server side. The client is thread safe, and serializes
+   * the queries of all threads on its single connection; use one client per thread for parallel queries.
+   */
+  class LocalBufferClient : public BufferInterface
+  {
+    public:
+      /** \brief LocalBufferClient constructor
+       * \param socket_path The path of the Unix domain socket the server listens on
+       */
+      LocalBufferClient(const std::string& socket_path);
+
+      virtual ~LocalBufferClient();
+
+      /** \brief Get the transform between two frames by frame ID.
+       * \param target_frame The frame to which data should be transformed
+       * \param source_frame The frame where the data originated
+       * \param time The time at which the value of the transform is desired. (0 will get the latest)
+       * \param timeout How long to block before failing
+       * \return The transform between the frames
+       *
+       * Possible exceptions tf2::LookupException, tf2::ConnectivityException,
+       * tf2::ExtrapolationException, tf2::InvalidArgumentException, and tf2::TransformException
+       * if the server cannot be reached
+       */
+      virtual geometry_msgs::TransformStamped
+        lookupTransform(const std::string& target_frame, const std::string& source_frame,
+            const ros::Time& time, const ros::Duration timeout = ros::Duration(0.0)) const;
+
+      /** \brief Get the transform between two frames by frame ID assuming fixed frame.
+       * \param target_frame The frame to which data should be transformed
+       * \param target_time The time to which the data should be transformed. (0 will get the latest)
+       * \param source_frame The frame where the data originated
+       * \param source_time The time at which the source_frame should be evaluated. (0 will get the latest)
+       * \param fixed_frame The frame in which to assume the transform is constant in time. 
+       * \param timeout How long to block before failing
+       * \return The transform between the frames
+       *
+       * Possible exceptions tf2::LookupException, tf2::ConnectivityException,
+       * tf2::ExtrapolationException, tf2::InvalidArgumentException, and tf2::TransformException
+       * if the server cannot be reached
+       */
+      virtual geometry_msgs::TransformStamped 
+        lookupTransform(const std::string& target_frame, const ros::Time& target_time,
+            const std::string& source_frame, const ros::Time& source_time,
+            const std::string& fixed_frame, const ros::Duration timeout = ros::Duration(0.0)) const;
+
+      /** \brief Test if a transform is possible
+       * \param target_frame The frame into which to transform
+       * \param source_frame The frame from which to transform
+       * \param time The time at which to transform
+       * \param timeout How long to block before failing
+       * \param errstr A pointer to a string which will be filled with why the transform failed, if not NULL
+       * \return True if the transform is possible, false otherwise 
+       */
+      virtual bool
+        canTransform(const std::string& target_frame, const std::string& source_frame, 
+            const ros::Time& time, const ros::Duration timeout = ros::Duration(0.0), std::string* errstr = NULL) const;
+
+      /** \brief Test if a transform is possible
+       * \param target_frame The frame into which to transform
+       * \param target_time The time into which to transform
+       * \param source_frame The frame from which to transform
+       * \param source_time The time from which to transform
+       * \param fixed_frame The frame in which to treat the transform as constant in time
+       * \param timeout How long to block before failing
+       * \param errstr A pointer to a string which will be filled with why the transform failed, if not NULL
+       * \return True if the transform is possible, false otherwise 
+       */
+      virtual bool
+        canTransform(const std::string& target_frame, const ros::Time& target_time,
+            const std::string& source_frame, const ros::Time& source_time,
+            const std::string& fixed_frame, const ros::Duration timeout = ros::Duration(0.0), std::string* errstr = NULL) const;
+
+      /** \brief Block until the server accepts a connection.
+       * \param timeout Time to wait for the server. (0 waits forever)
+       * \return True if connected, false otherwise.
+       */
+      bool waitForServer(const ros::WallDuration& timeout = ros::WallDuration(0));
+
+    private:
+      bool connect() const;
+      void disconnect() const;
+      geometry_msgs::TransformStamped query(uint8_t op, bool advanced,
+          const std::string& target_frame, const ros::Time& target_time,
+          const std::string& source_frame, const ros::Time& source_time,
+          const std::string& fixed_frame, const ros::Duration& timeout) const;
+
+      std::string socket_path_;
+      mutable int fd_;
+      mutable boost::mutex mutex_;
+  };
+};
+#endif
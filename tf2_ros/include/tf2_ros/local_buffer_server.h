@@ -0,0 +1,96 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#ifndef TF2_ROS_LOCAL_BUFFER_SERVER_H_
+#define TF2_ROS_LOCAL_BUFFER_SERVER_H_
+
+#include <tf2_ros/buffer.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tf2_ros
+{
+  /** \brief Serves lookups from a Buffer to other processes on the same host over a Unix domain socket.
+   *
+   * Use this class with a tf2_ros::TransformListener in the same process, so that a single
+   * process ingests /tf for the whole host. Other processes attach with a tf2_ros::LocalBufferClient,
+   * which costs one local round trip per query instead of an actionlib goal, and does not require
+   * every process to keep its own listener and buffer.
+   */
+  class LocalBufferServer
+  {
+    public:
+      /** \brief Constructor
+       * \param buffer The Buffer that this LocalBufferServer will wrap.
+       * \param socket_path The filesystem path of the Unix domain socket to listen on.
+       * Any stale socket at that path is removed when the server starts.
+       */
+      LocalBufferServer(const Buffer& buffer, const std::string& socket_path);
+
+      ~LocalBufferServer();
+
+      /** \brief Bind the socket and start accepting clients.
+       * \return True if the socket could be bound and the server is running
+       */
+      bool start();
+
+      /** \brief Stop accepting clients, disconnect all clients and remove the socket. */
+      void stop();
+
+    private:
+      typedef boost::shared_ptr<boost::thread> ThreadPtr;
+
+      void acceptThread();
+      void clientThread(int fd);
+      bool processRequest(int fd);
+      /// Join the threads of the clients which disconnected
+      void joinFinishedClients();
+
+      const Buffer& buffer_;
+      std::string socket_path_;
+      int listen_fd_;
+
+      /// Threads of the connected clients by socket, and of the ones which disconnected but are not joined yet
+      boost::mutex clients_mutex_;
+      std::map<int, ThreadPtr> client_threads_;
+      std::vector<ThreadPtr> finished_threads_;
+      boost::thread accept_thread_;
+  };
+};
+#endif
@@ -34,8 +34,11 @@
 
 #include <tf2/buffer_core.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <list>
+#include <map>
 #include <vector>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
@@ -49,6 +52,8 @@
 #include <ros/callback_queue_interface.h>
 #include <ros/init.h>
 
+#include <tf2_msgs/MessageFilterStatistics.h>
+
 #define TF2_ROS_MESSAGEFILTER_DEBUG(fmt, ...) \
   ROS_DEBUG_NAMED("message_filter", std::string(std::string("MessageFilter [target=%s]: ") + std::string(fmt)).c_str(), getTargetFramesString().c_str(), __VA_ARGS__)
 
@@ -68,10 +73,73 @@ enum FilterFailureReason
   OutTheBack,
   /// The frame_id on the message is empty
   EmptyFrameID,
+  /// The transform did not become available within the timeout set with MessageFilter::setTimeout
+  Timeout,
 };
 }
 typedef filter_failure_reasons::FilterFailureReason FilterFailureReason;
 
+/**
+ * \brief Histogram of the time messages waited in a MessageFilter before they were passed on or dropped
+ * Adding a sample is O(1) and allocation free.
+ */
+struct WaitStatistics
+{
+  static const unsigned int NUM_BUCKETS = 12;
+
+  WaitStatistics()
+  : ready_count(0), dropped_count(0), total_wait(0.0), max_wait(0.0)
+  {
+    std::fill(buckets, buckets + NUM_BUCKETS, 0);
+  }
+
+  void add(double wait, bool ready)
+  {
+    if (ready)
+      ++ready_count;
+    else
+      ++dropped_count;
+    total_wait += wait;
+    max_wait = std::max(max_wait, wait);
+
+    unsigned int i = 0;
+    while (i + 1 < NUM_BUCKETS && wait >= bucketLimit(i))
+      ++i;
+    ++buckets[i];
+  }
+
+  uint64_t count() const { return ready_count + dropped_count; }
+  double meanWait() const { return count() ? total_wait / count() : 0.0; }
+
+  /** \brief Upper bound of the histogram bucket holding the given quantile */
+  double quantile(double q) const
+  {
+    uint64_t target = (uint64_t)std::ceil(q * count());
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+      seen += buckets[i];
+      if (seen >= target && seen > 0)
+        return (i + 1 < NUM_BUCKETS) ? bucketLimit(i) : max_wait;
+    }
+    return max_wait;
+  }
+
+  /** \brief Upper bound of bucket i in seconds, the last bucket is unbounded */
+  static double bucketLimit(unsigned int i)
+  {
+    // 1ms, 2ms, 5ms, 10ms, ... 2s
+    static const double limits[NUM_BUCKETS - 1] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0};
+    return limits[i];
+  }
+
+  uint64_t ready_count;
+  uint64_t dropped_count;
+  double total_wait;
+  double max_wait;
+  uint64_t buckets[NUM_BUCKETS];
+};
+
 class MessageFilterBase
 {
 public:
@@ -215,6 +283,7 @@ public:
   ~MessageFilter()
   {
     message_connection_.disconnect();
+    statistics_timer_.stop();
 
     MessageFilter::clear();
 
@@ -244,7 +313,7 @@ public:
 
     target_frames_.resize(target_frames.size());
     std::transform(target_frames.begin(), target_frames.end(), target_frames_.begin(), this->stripSlash);
-    expected_success_count_ = target_frames_.size() * (time_tolerance_.isZero() ? 1 : 2);
+    expected_success_count_ = target_frames_.size();
 
     std::stringstream ss;
     for (V_string::iterator it = target_frames_.begin(); it != target_frames_.end(); ++it)
@@ -269,7 +338,18 @@ public:
   {
     boost::mutex::scoped_lock lock(target_frames_mutex_);
     time_tolerance_ = tolerance;
-    expected_success_count_ = target_frames_.size() * (time_tolerance_.isZero() ? 1 : 2);
+  }
+
+  /**
+   * \brief Drop messages whose transforms are not available after waiting for timeout
+   * The wait is measured in wall time, so messages also leave the queue when /tf stops altogether.
+   * Zero, the default, waits until the message is pushed out of the queue or out of the cache.
+   * Applies to messages added afterwards.
+   */
+  void setTimeout(const ros::WallDuration& timeout)
+  {
+    boost::mutex::scoped_lock lock(target_frames_mutex_);
+    timeout_ = timeout;
   }
 
   /**
@@ -317,10 +397,14 @@ public:
     info.handles.reserve(expected_success_count_);
     {
       V_string target_frames_copy;
+      ros::WallDuration timeout;
+      ros::Duration time_tolerance;
       // Copy target_frames_ to avoid deadlock from #79
       {
         boost::mutex::scoped_lock frames_lock(target_frames_mutex_);
         target_frames_copy = target_frames_;
+        timeout = timeout_;
+        time_tolerance = time_tolerance_;
       }
 
       V_string::iterator it = target_frames_copy.begin();
@@ -328,9 +412,12 @@ public:
       for (; it != end; ++it)
       {
         const std::string& target_frame = *it;
-        tf2::TransformableRequestHandle handle = bc_.addTransformableRequest(callback_handle_, target_frame, frame_id, stamp);
+        // With a tolerance a single request covers [stamp, stamp + tolerance]
+        tf2::TransformableRequestHandle handle = bc_.addTransformableRequest(callback_handle_, target_frame, frame_id,
+                                                                             stamp, stamp + time_tolerance, timeout);
         if (handle == 0xffffffffffffffffULL) // never transformable
         {
+          recordWait(frame_id, ros::WallDuration(), false);
           messageDropped(evt, filter_failure_reasons::OutTheBack);
           return;
         }
@@ -342,24 +429,6 @@ public:
         {
           info.handles.push_back(handle);
         }
-
-        if (!time_tolerance_.isZero())
-        {
-          handle = bc_.addTransformableRequest(callback_handle_, target_frame, frame_id, stamp + time_tolerance_);
-          if (handle == 0xffffffffffffffffULL) // never transformable
-          {
-            messageDropped(evt, filter_failure_reasons::OutTheBack);
-            return;
-          }
-          else if (handle == 0)
-          {
-            ++info.success_count;
-          }
-          else
-          {
-            info.handles.push_back(handle);
-          }
-        }
       }
     }
 
@@ -367,6 +436,7 @@ public:
     // We can transform already
     if (info.success_count == expected_success_count_)
     {
+      recordWait(frame_id, ros::WallDuration(), true);
       messageReady(evt);
     }
     else
@@ -388,6 +458,7 @@ public:
           bc_.cancelTransformableRequest(*it);
         }
 
+        recordWait(stripSlash(mt::FrameId<M>::value(*front.event.getMessage())), ros::WallTime::now() - front.arrival, false);
         messageDropped(front.event, filter_failure_reasons::Unknown);
         messages_.pop_front();
          --message_count_;
@@ -395,6 +466,7 @@ public:
 
       // Add the message to our list
       info.event = evt;
+      info.arrival = ros::WallTime::now();
       messages_.push_back(info);
       ++message_count_;
     }
@@ -428,6 +500,79 @@ public:
     return message_filters::Connection(boost::bind(&MessageFilter::disconnectFailure, this, _1), failure_signal_.connect(callback));
   }
 
+  /// Source frame and the target frames, as returned by getTargetFramesString, the messages waited for
+  typedef std::pair<std::string, std::string> WaitStatisticsKey;
+  typedef std::map<WaitStatisticsKey, WaitStatistics> M_WaitStatistics;
+
+  /**
+   * \brief Get the time messages waited for their transforms, per source frame and set of target frames
+   * Covers the messages which left the filter since it was created or the statistics were reset.
+   */
+  M_WaitStatistics getWaitStatistics() const
+  {
+    boost::mutex::scoped_lock lock(wait_statistics_mutex_);
+    return wait_statistics_;
+  }
+
+  /**
+   * \brief Forget the wait statistics collected so far
+   */
+  void resetWaitStatistics()
+  {
+    boost::mutex::scoped_lock lock(wait_statistics_mutex_);
+    wait_statistics_.clear();
+  }
+
+  /**
+   * \brief Publish the wait statistics as tf2_msgs/MessageFilterStatistics every period
+   * \param nh The NodeHandle to advertise the topic on, whose callback queue drives the publishing
+   * \param period How often to publish, zero stops publishing
+   * \param topic The topic to publish on
+   */
+  void publishWaitStatistics(ros::NodeHandle nh, const ros::WallDuration& period,
+                             const std::string& topic = "message_filter_statistics")
+  {
+    statistics_timer_.stop();
+    if (period.isZero())
+    {
+      statistics_pub_.shutdown();
+      return;
+    }
+
+    statistics_pub_ = nh.advertise<tf2_msgs::MessageFilterStatistics>(topic, 1);
+    statistics_timer_ = nh.createWallTimer(period, &MessageFilter::publishWaitStatisticsCallback, this);
+  }
+
+  /**
+   * \brief Fill a tf2_msgs/MessageFilterStatistics with the current wait statistics, except for the header
+   */
+  void getWaitStatistics(tf2_msgs::MessageFilterStatistics& msg)
+  {
+    msg.target_frames = getTargetFramesString();
+
+    M_WaitStatistics statistics = getWaitStatistics();
+    msg.sources.resize(statistics.size());
+    size_t i = 0;
+    for (typename M_WaitStatistics::const_iterator it = statistics.begin(); it != statistics.end(); ++it, ++i)
+    {
+      const WaitStatistics& stats = it->second;
+      tf2_msgs::WaitStatistics& source = msg.sources[i];
+      source.source_frame = it->first.first;
+      source.target_frames = it->first.second;
+      source.ready_count = stats.ready_count;
+      source.dropped_count = stats.dropped_count;
+      source.mean_wait = ros::Duration(stats.meanWait());
+      source.max_wait = ros::Duration(stats.max_wait);
+      source.p50_wait = ros::Duration(stats.quantile(0.5));
+      source.p90_wait = ros::Duration(stats.quantile(0.9));
+      source.p99_wait = ros::Duration(stats.quantile(0.99));
+      source.bucket_limits.resize(WaitStatistics::NUM_BUCKETS - 1);
+      for (unsigned int b = 0; b + 1 < WaitStatistics::NUM_BUCKETS; ++b)
+        source.bucket_limits[b] = ros::Duration(WaitStatistics::bucketLimit(b));
+      source.bucket_counts.assign(stats.buckets, stats.buckets + WaitStatistics::NUM_BUCKETS);
+    }
+  }
+
   virtual void setQueueSize( uint32_t new_queue_size )
   {
     queue_size_ = new_queue_size;
@@ -450,6 +595,7 @@ private:
     incoming_message_count_ = 0;
     dropped_message_count_ = 0;
     time_tolerance_ = ros::Duration(0.0);
+    timeout_ = ros::WallDuration(0.0);
     warned_about_empty_frame_id_ = false;
     expected_success_count_ = 1;
 
@@ -483,6 +629,32 @@ private:
       return;
     }
 
+    if (result == tf2::TransformTimeout)
+    {
+      // Give up on the message right away instead of waiting for its other requests
+      boost::upgrade_to_unique_lock< boost::shared_mutex > uniqueLock(lock);
+      const MessageInfo& info = *msg_it;
+      V_TransformableRequestHandle::const_iterator it = info.handles.begin();
+      V_TransformableRequestHandle::const_iterator end = info.handles.end();
+      for (; it != end; ++it)
+      {
+        if (*it != request_handle)
+        {
+          bc_.cancelTransformableRequest(*it);
+        }
+      }
+
+      ++dropped_message_count_;
+      recordWait(stripSlash(mt::FrameId<M>::value(*info.event.getMessage())), ros::WallTime::now() - info.arrival, false);
+      TF2_ROS_MESSAGEFILTER_DEBUG("Discarding message in frame %s at time %.3f after timeout, count now %d",
+                                  mt::FrameId<M>::value(*info.event.getMessage()).c_str(),
+                                  mt::TimeStamp<M>::value(*info.event.getMessage()).toSec(), message_count_ - 1);
+      messageDropped(info.event, filter_failure_reasons::Timeout);
+      messages_.erase(msg_it);
+      --message_count_;
+      return;
+    }
+
     const MessageInfo& info = *msg_it;
     if (info.success_count < expected_success_count_)
     {
@@ -497,26 +669,18 @@ private:
     if (result == tf2::TransformAvailable)
     {
       boost::mutex::scoped_lock frames_lock(target_frames_mutex_);
-      // make sure we can still perform all the necessary transforms
+      // make sure we can still perform all the necessary transforms. The requests covered the whole
+      // [stamp, stamp + time_tolerance_] interval when they succeeded, so one check per target is enough
+      // to catch data cleared since then.
       typename V_string::iterator it = target_frames_.begin();
       typename V_string::iterator end = target_frames_.end();
       for (; it != end; ++it)
       {
-        const std::string& target = *it;
-        if (!bc_.canTransform(target, frame_id, stamp))
+        if (!bc_.canTransform(*it, frame_id, stamp))
         {
           can_transform = false;
           break;
         }
-
-        if (!time_tolerance_.isZero())
-        {
-          if (!bc_.canTransform(target, frame_id, stamp + time_tolerance_))
-          {
-            can_transform = false;
-            break;
-          }
-        }
       }
     }
     else
@@ -532,6 +696,7 @@ private:
 
       ++successful_transform_count_;
 
+      recordWait(frame_id, ros::WallTime::now() - info.arrival, true);
       messageReady(info.event);
 
     }
@@ -539,6 +704,7 @@ private:
     {
       ++dropped_message_count_;
 
+      recordWait(frame_id, ros::WallTime::now() - info.arrival, false);
       TF2_ROS_MESSAGEFILTER_DEBUG("Discarding message in frame %s at time %.3f, count now %d", frame_id.c_str(), stamp.toSec(), message_count_ - 1);
       messageDropped(info.event, filter_failure_reasons::Unknown);
     }
@@ -547,6 +713,21 @@ private:
     --message_count_;
   }
 
+  void recordWait(const std::string& frame_id, const ros::WallDuration& wait, bool ready)
+  {
+    boost::mutex::scoped_lock frames_lock(target_frames_mutex_);
+    boost::mutex::scoped_lock lock(wait_statistics_mutex_);
+    wait_statistics_[WaitStatisticsKey(frame_id, target_frames_string_)].add(wait.toSec(), ready);
+  }
+
+  void publishWaitStatisticsCallback(const ros::WallTimerEvent&)
+  {
+    tf2_msgs::MessageFilterStatistics msg;
+    getWaitStatistics(msg);
+    msg.header.stamp = ros::Time::now();
+    statistics_pub_.publish(msg);
+  }
+
   /**
    * \brief Callback that happens when we receive a message on the message topic
    */
@@ -681,6 +862,7 @@ private:
     MEvent event;
     V_TransformableRequestHandle handles;
     uint32_t success_count;
+    ros::WallTime arrival; ///< When the message was queued, for the wait statistics
   };
   typedef std::list<MessageInfo> L_MessageInfo;
   L_MessageInfo messages_;
@@ -702,6 +884,7 @@ private:
   ros::WallTime next_failure_warning_;
 
   ros::Duration time_tolerance_; ///< Provide additional tolerance on time for messages which are stamped but can have associated duration
+  ros::WallDuration timeout_; ///< How long a message may wait for its transforms, zero for no limit
 
   message_filters::Connection message_connection_;
 
@@ -709,6 +892,11 @@ private:
   boost::mutex failure_signal_mutex_;
 
   ros::CallbackQueueInterface* callback_queue_;
+
+  M_WaitStatistics wait_statistics_; ///< Wait time statistics per source frame and set of target frames
+  mutable boost::mutex wait_statistics_mutex_;
+  ros::Publisher statistics_pub_;
+  ros::WallTimer statistics_timer_;
 };
 
 } // namespace tf2
@@ -0,0 +1,79 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#ifndef TF2_ROS_SHARED_BUFFER_H_
+#define TF2_ROS_SHARED_BUFFER_H_
+
+#include <tf2_ros/buffer.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <map>
+#include <string>
+
+namespace tf2_ros
+{
+  /** \brief A Buffer and TransformListener shared by every user in the process which asks for the same name.
+   *
+   * Nodelets loaded into one manager usually each create a Buffer and a TransformListener, so every one of
+   * them subscribes to /tf and /tf_static, deserializes every message and keeps its own history. Getting the
+   * buffer from here instead lets a single listener feed all of them. The buffer lives for as long as any
+   * user holds it, and its listener unsubscribes once the last user lets go.
+   */
+  class SharedBuffer
+  {
+    public:
+      /** \brief Get the buffer shared under name, creating it and its listener on first use
+       * \param name Users which ask for the same name share a buffer, the empty name is the default one
+       * \param cache_time How much history this user needs. The buffer keeps the longest any user asked for.
+       * \return The buffer, which stays alive at least as long as the returned pointer
+       */
+      static boost::shared_ptr<Buffer> get(const std::string& name = std::string(),
+                                           const ros::Duration& cache_time = ros::Duration(tf2::BufferCore::DEFAULT_CACHE_TIME));
+
+      /** \brief Number of shared buffers which are alive, for debugging */
+      static size_t count();
+
+    private:
+      SharedBuffer();
+
+      struct Entry;
+      typedef std::map<std::string, boost::weak_ptr<Entry> > M_Entry;
+      /// The buffers by name. Only weak references are held, so the users alone keep them alive.
+      static M_Entry& entries();
+      static boost::mutex& entriesMutex();
+  };
+};
+#endif
@@ -34,12 +34,18 @@
 
 #include "std_msgs/Empty.h"
 #include "tf2_msgs/TFMessage.h"
+#include "tf2_msgs/TransformHistory.h"
 #include "ros/ros.h"
 #include "ros/callback_queue.h"
 
 #include "tf2_ros/buffer.h"
 
 #include "boost/thread.hpp"
+#include "boost/unordered_map.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
 
 namespace tf2_ros{
 
@@ -57,6 +63,27 @@ public:
 
   ~TransformListener();
 
+  /** \brief Collapse a backlog of /tf messages instead of inserting every one of them
+   * When the listener thread falls behind, all messages which queued up are drained together. If there
+   * are more than max_backlog of them, only the latest sample of every frame and every keep_every-th
+   * older one (none for 0) are inserted, so catching up after a stall costs about one sample per frame
+   * rather than the whole backlog. /tf_static is never collapsed.
+   * Only applies with the dedicated listener thread, a max_backlog of 0 (the default) turns it off.
+   */
+  void setLoadShedding(unsigned int max_backlog, unsigned int keep_every = 0);
+
+  /** \brief Fill the buffer with the history cached by a running tf2_ros::BufferServer
+   * Call it right after construction, so that a new node can transform data stamped before it started.
+   * The history is fetched in one call of the service <server_ns>/history.
+   * \param server_ns The namespace of the BufferServer
+   * \param frames The frames to fetch, all frames if empty
+   * \param history How far back to fetch, at most the cache time of the buffer. 0 fetches as much as it holds.
+   * \param timeout How long to wait for the service to come up
+   * \return True if the history was fetched and inserted
+   */
+  bool loadHistory(const std::string& server_ns, const std::vector<std::string>& frames = std::vector<std::string>(),
+                   ros::Duration history = ros::Duration(), ros::Duration timeout = ros::Duration(1.0));
+
 private:
 
   /// Initialize this transform listener, subscribing, advertising services, etc.
@@ -68,6 +95,25 @@ private:
   void static_subscription_callback(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt);
   void subscription_callback_impl(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt, bool is_static);
 
+  /// Clear the data after now if time jumped back since the last message
+  void checkTimeJump(const ros::Time& now);
+  /// Insert transforms, reporting failures instead of throwing
+  void insertTransforms(const std::vector<geometry_msgs::TransformStamped>& transforms, const std::string& authority, bool is_static);
+  /// Insert the messages received during one pass of the dedicated thread
+  void insertPending();
+  /// Insert the latest samples of a backlog per frame, see setLoadShedding
+  void insertCollapsed(unsigned int keep_every);
+  /// Insert the history fetched by loadHistory next to the live data already received
+  bool insertHistory(const std::vector<tf2_msgs::FrameHistory>& frames, const std::string& authority);
+
+  struct PendingMessage
+  {
+    tf2_msgs::TFMessageConstPtr message;
+    std::string authority;
+    bool is_static;
+  };
+  typedef std::vector<geometry_msgs::TransformStamped> V_TransformStamped;
+
   ros::CallbackQueue tf_message_callback_queue_;
   boost::thread* dedicated_listener_thread_;
   ros::NodeHandle node_;
@@ -77,15 +123,51 @@ private:
   bool using_dedicated_thread_;
   ros::TransportHints transport_hints_;
   ros::Time last_update_;
- 
+
+  /// Messages received by the dedicated thread which are not inserted yet, only touched by that thread
+  std::vector<PendingMessage> pending_;
+  /// Samples seen per frame and samples kept per authority while collapsing, kept for their memory
+  boost::unordered_map<std::string, unsigned int> samples_per_frame_;
+  std::map<std::string, V_TransformStamped> collapsed_;
+
+  boost::mutex load_shedding_mutex_;
+  unsigned int max_backlog_;
+  unsigned int keep_every_;
+
   void dedicatedListenerThread()
   {
     while (using_dedicated_thread_)
     {
       tf_message_callback_queue_.callAvailable(ros::WallDuration(0.01));
+      insertPending();
     }
   };
 
+  friend class TestTransformListener; // For unit testing
+};
+
+/** A helper class for testing internal APIs */
+class TestTransformListener
+{
+public:
+  void _receive(TransformListener& listener, const tf2_msgs::TFMessageConstPtr& message, const std::string& authority, bool is_static) const
+  {
+    TransformListener::PendingMessage pending = {message, authority, is_static};
+    listener.pending_.push_back(pending);
+  }
+  void _insertPending(TransformListener& listener) const
+  {
+    listener.insertPending();
+  }
+  void _checkTimeJump(TransformListener& listener, const ros::Time& now) const
+  {
+    listener.checkTimeJump(now);
+  }
+  bool _insertHistory(TransformListener& listener, const std::vector<tf2_msgs::FrameHistory>& frames,
+                      const std::string& authority) const
+  {
+    return listener.insertHistory(frames, authority);
+  }
 };
 }
 
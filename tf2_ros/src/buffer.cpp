@@ -47,6 +47,7 @@ Buffer::Buffer(ros::Duration cache_time, bool debug) :
   {
     ros::NodeHandle n("~");
     frames_server_ = n.advertiseService("tf2_frames", &Buffer::getFrames, this);
+    frame_info_server_ = n.advertiseService("tf2_frame_info", &Buffer::getFrameInfo, this);
   }
 }
 
@@ -180,6 +181,12 @@ bool Buffer::getFrames(tf2_msgs::FrameGraph::Request& req, tf2_msgs::FrameGraph:
   return true;
 }
 
+bool Buffer::getFrameInfo(tf2_msgs::FrameInfoGraph::Request& req, tf2_msgs::FrameInfoGraph::Response& res)
+{
+  allFramesAsFrameInfo(res.frames);
+  return true;
+}
+
 
 
 bool Buffer::checkAndErrorDedicatedThreadPresent(std::string* error_str) const
@@ -48,6 +48,13 @@ namespace tf2_ros
   {
     ros::NodeHandle n;
     check_timer_ = n.createTimer(check_period, boost::bind(&BufferServer::checkTransforms, this, _1));
+    history_service_ = n.advertiseService(ns + "/history", &BufferServer::historyCB, this);
+  }
+
+  bool BufferServer::historyCB(tf2_msgs::TransformHistory::Request& req, tf2_msgs::TransformHistory::Response& res)
+  {
+    buffer_.getFrameHistory(req.frame_ids, req.history, res.frames);
+    return true;
   }
 
   void BufferServer::checkTransforms(const ros::TimerEvent& e)
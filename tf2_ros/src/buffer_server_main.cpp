@@ -35,6 +35,7 @@
 * Author: Wim Meeussen
 *********************************************************************/
 #include <tf2_ros/buffer_server.h>
+#include <tf2_ros/local_buffer_server.h>
 #include <tf2_ros/transform_listener.h>
 #include <ros/ros.h>
 
@@ -67,5 +68,12 @@ int main(int argc, char** argv)
   tf2_ros::BufferServer buffer_server(buffer_core, node_name , false);
   buffer_server.start();
 
+  // Optionally share the buffer with other processes on this host over a Unix domain socket
+  std::string local_socket_path;
+  nh.param("local_socket_path", local_socket_path, std::string());
+  tf2_ros::LocalBufferServer local_buffer_server(buffer_core, local_socket_path);
+  if (!local_socket_path.empty())
+    local_buffer_server.start();
+
   ros::spin();
 }
@@ -0,0 +1,210 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#include <tf2_ros/local_buffer_client.h>
+#include "local_buffer_protocol.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace tf2_ros
+{
+  namespace protocol = local_buffer_protocol;
+
+  LocalBufferClient::LocalBufferClient(const std::string& socket_path) :
+    socket_path_(socket_path),
+    fd_(-1)
+  {
+  }
+
+  LocalBufferClient::~LocalBufferClient()
+  {
+    disconnect();
+  }
+
+  bool LocalBufferClient::connect() const
+  {
+    if (fd_ >= 0)
+      return true;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.size() >= sizeof(addr.sun_path))
+      return false;
+    strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0)
+      return false;
+    if (::connect(fd_, (sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  void LocalBufferClient::disconnect() const
+  {
+    if (fd_ >= 0)
+    {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  bool LocalBufferClient::waitForServer(const ros::WallDuration& timeout)
+  {
+    ros::WallTime end_time = ros::WallTime::now() + timeout;
+    while (true)
+    {
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (connect())
+          return true;
+      }
+      if (!timeout.isZero() && ros::WallTime::now() >= end_time)
+        return false;
+      ros::WallDuration(0.01).sleep();
+    }
+  }
+
+  geometry_msgs::TransformStamped LocalBufferClient::query(uint8_t op, bool advanced,
+      const std::string& target_frame, const ros::Time& target_time,
+      const std::string& source_frame, const ros::Time& source_time,
+      const std::string& fixed_frame, const ros::Duration& timeout) const
+  {
+    protocol::RequestHeader request;
+    memset(&request, 0, sizeof(request));
+    request.op = op;
+    request.advanced = advanced;
+    request.target_frame_length = target_frame.size();
+    request.source_frame_length = source_frame.size();
+    request.fixed_frame_length = fixed_frame.size();
+    request.target_time_sec = target_time.sec;
+    request.target_time_nsec = target_time.nsec;
+    request.source_time_sec = source_time.sec;
+    request.source_time_nsec = source_time.nsec;
+    request.timeout_sec = timeout.sec;
+    request.timeout_nsec = timeout.nsec;
+
+    std::string out(reinterpret_cast<const char*>(&request), sizeof(request));
+    out += target_frame;
+    out += source_frame;
+    out += fixed_frame;
+
+    boost::mutex::scoped_lock lock(mutex_);
+    protocol::ResponseHeader response;
+    geometry_msgs::TransformStamped transform;
+    std::string error_string;
+    // Reconnect once if the server was restarted since the last query
+    for (int attempt = 0; ; ++attempt)
+    {
+      if (connect() &&
+          protocol::writeAll(fd_, out.data(), out.size()) &&
+          protocol::readAll(fd_, &response, sizeof(response)) &&
+          protocol::readString(fd_, response.frame_id_length, transform.header.frame_id) &&
+          protocol::readString(fd_, response.child_frame_id_length, transform.child_frame_id) &&
+          protocol::readString(fd_, response.error_string_length, error_string))
+        break;
+
+      disconnect();
+      if (attempt > 0)
+        throw tf2::TransformException("Could not reach the local buffer server at " + socket_path_);
+    }
+
+    protocol::throwError(response.error, error_string);
+
+    transform.header.stamp = ros::Time(response.stamp_sec, response.stamp_nsec);
+    transform.transform.translation.x = response.translation[0];
+    transform.transform.translation.y = response.translation[1];
+    transform.transform.translation.z = response.translation[2];
+    transform.transform.rotation.x = response.rotation[0];
+    transform.transform.rotation.y = response.rotation[1];
+    transform.transform.rotation.z = response.rotation[2];
+    transform.transform.rotation.w = response.rotation[3];
+    return transform;
+  }
+
+  geometry_msgs::TransformStamped LocalBufferClient::lookupTransform(const std::string& target_frame, const std::string& source_frame,
+      const ros::Time& time, const ros::Duration timeout) const
+  {
+    return query(protocol::LOOKUP_TRANSFORM, false, target_frame, ros::Time(), source_frame, time, std::string(), timeout);
+  }
+
+  geometry_msgs::TransformStamped LocalBufferClient::lookupTransform(const std::string& target_frame, const ros::Time& target_time,
+      const std::string& source_frame, const ros::Time& source_time,
+      const std::string& fixed_frame, const ros::Duration timeout) const
+  {
+    return query(protocol::LOOKUP_TRANSFORM, true, target_frame, target_time, source_frame, source_time, fixed_frame, timeout);
+  }
+
+  bool LocalBufferClient::canTransform(const std::string& target_frame, const std::string& source_frame, 
+        const ros::Time& time, const ros::Duration timeout, std::string* errstr) const
+  {
+    try
+    {
+      query(protocol::CAN_TRANSFORM, false, target_frame, ros::Time(), source_frame, time, std::string(), timeout);
+      return true;
+    }
+    catch(tf2::TransformException& ex)
+    {
+      if(errstr)
+        *errstr = ex.what();
+      return false;
+    }
+  }
+
+  bool LocalBufferClient::canTransform(const std::string& target_frame, const ros::Time& target_time,
+        const std::string& source_frame, const ros::Time& source_time,
+        const std::string& fixed_frame, const ros::Duration timeout, std::string* errstr) const
+  {
+    try
+    {
+      query(protocol::CAN_TRANSFORM, true, target_frame, target_time, source_frame, source_time, fixed_frame, timeout);
+      return true;
+    }
+    catch(tf2::TransformException& ex)
+    {
+      if(errstr)
+        *errstr = ex.what();
+      return false;
+    }
+  }
+};
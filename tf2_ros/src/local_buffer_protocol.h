@@ -0,0 +1,160 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#ifndef TF2_ROS_LOCAL_BUFFER_PROTOCOL_H_
+#define TF2_ROS_LOCAL_BUFFER_PROTOCOL_H_
+
+#include <tf2/exceptions.h>
+#include <tf2_msgs/TF2Error.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+/* Wire format shared by LocalBufferServer and LocalBufferClient.
+ * Both ends run on the same host, so the fixed size headers are sent in native layout
+ * and are followed by the frame id strings (no terminators).
+ */
+
+namespace tf2_ros
+{
+namespace local_buffer_protocol
+{
+
+enum Operation
+{
+  LOOKUP_TRANSFORM = 1,
+  CAN_TRANSFORM = 2
+};
+
+static const uint32_t MAX_STRING_LENGTH = 65536;
+
+struct RequestHeader
+{
+  uint8_t op;
+  uint8_t advanced;
+  uint16_t reserved;
+  uint32_t target_frame_length;
+  uint32_t source_frame_length;
+  uint32_t fixed_frame_length;
+  uint32_t target_time_sec, target_time_nsec;
+  uint32_t source_time_sec, source_time_nsec;
+  int32_t timeout_sec, timeout_nsec;
+};
+
+struct ResponseHeader
+{
+  uint8_t error;
+  uint8_t reserved[3];
+  uint32_t frame_id_length;
+  uint32_t child_frame_id_length;
+  uint32_t error_string_length;
+  uint32_t stamp_sec, stamp_nsec;
+  double translation[3];
+  double rotation[4];
+};
+
+/** \brief Write all of size bytes, returns false if the connection failed.
+ * Uses MSG_NOSIGNAL so a peer that went away does not raise SIGPIPE.
+ */
+inline bool writeAll(int fd, const void* data, size_t size)
+{
+  const char* p = static_cast<const char*>(data);
+  while (size > 0)
+  {
+    ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+/** \brief Read exactly size bytes, returns false if the connection failed or was closed */
+inline bool readAll(int fd, void* data, size_t size)
+{
+  char* p = static_cast<char*>(data);
+  while (size > 0)
+  {
+    ssize_t n = ::read(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+inline bool readString(int fd, uint32_t length, std::string& out)
+{
+  if (length > MAX_STRING_LENGTH)
+    return false;
+  out.resize(length);
+  return length == 0 || readAll(fd, &out[0], length);
+}
+
+/** \brief Rethrow an error received from the server as the matching tf2 exception */
+inline void throwError(uint8_t error, const std::string& error_string)
+{
+  switch (error)
+  {
+    case tf2_msgs::TF2Error::NO_ERROR:
+      return;
+    case tf2_msgs::TF2Error::LOOKUP_ERROR:
+      throw tf2::LookupException(error_string);
+    case tf2_msgs::TF2Error::CONNECTIVITY_ERROR:
+      throw tf2::ConnectivityException(error_string);
+    case tf2_msgs::TF2Error::EXTRAPOLATION_ERROR:
+      throw tf2::ExtrapolationException(error_string);
+    case tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR:
+      throw tf2::InvalidArgumentException(error_string);
+    case tf2_msgs::TF2Error::TIMEOUT_ERROR:
+      throw tf2::TimeoutException(error_string);
+    default:
+      throw tf2::TransformException(error_string);
+  }
+}
+
+}  // namespace local_buffer_protocol
+}  // namespace tf2_ros
+
+#endif  // TF2_ROS_LOCAL_BUFFER_PROTOCOL_H_
@@ -0,0 +1,263 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#include <tf2_ros/local_buffer_server.h>
+#include "local_buffer_protocol.h"
+
+#include <ros/console.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace tf2_ros
+{
+  namespace protocol = local_buffer_protocol;
+
+  LocalBufferServer::LocalBufferServer(const Buffer& buffer, const std::string& socket_path) :
+    buffer_(buffer),
+    socket_path_(socket_path),
+    listen_fd_(-1)
+  {
+  }
+
+  LocalBufferServer::~LocalBufferServer()
+  {
+    stop();
+  }
+
+  bool LocalBufferServer::start()
+  {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.empty() || socket_path_.size() >= sizeof(addr.sun_path))
+    {
+      ROS_ERROR("Invalid socket path for the local buffer server: \"%s\"", socket_path_.c_str());
+      return false;
+    }
+    strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+    {
+      ROS_ERROR("Could not create the local buffer server socket: %s", strerror(errno));
+      return false;
+    }
+
+    unlink(socket_path_.c_str());
+    if (bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd_, 16) != 0)
+    {
+      ROS_ERROR("Could not listen on %s: %s", socket_path_.c_str(), strerror(errno));
+      close(listen_fd_);
+      listen_fd_ = -1;
+      return false;
+    }
+
+    accept_thread_ = boost::thread(boost::bind(&LocalBufferServer::acceptThread, this));
+    return true;
+  }
+
+  void LocalBufferServer::stop()
+  {
+    if (listen_fd_ < 0)
+      return;
+
+    // Unblock accept(), so no client is added anymore, then every client read(), and wait for the threads
+    shutdown(listen_fd_, SHUT_RDWR);
+    accept_thread_.join();
+    std::vector<ThreadPtr> threads;
+    {
+      boost::mutex::scoped_lock lock(clients_mutex_);
+      for (std::map<int, ThreadPtr>::iterator it = client_threads_.begin(); it != client_threads_.end(); ++it)
+      {
+        shutdown(it->first, SHUT_RDWR);
+        threads.push_back(it->second);
+      }
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+      threads[i]->join();
+    joinFinishedClients();
+
+    close(listen_fd_);
+    listen_fd_ = -1;
+    unlink(socket_path_.c_str());
+  }
+
+  void LocalBufferServer::acceptThread()
+  {
+    while (true)
+    {
+      int fd = accept(listen_fd_, NULL, NULL);
+      if (fd < 0)
+      {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        // the listening socket was shut down
+        return;
+      }
+
+      joinFinishedClients();
+      // The client thread takes the lock before it exits, so it always finds itself in the map
+      boost::mutex::scoped_lock lock(clients_mutex_);
+      client_threads_[fd].reset(new boost::thread(boost::bind(&LocalBufferServer::clientThread, this, fd)));
+    }
+  }
+
+  void LocalBufferServer::joinFinishedClients()
+  {
+    std::vector<ThreadPtr> threads;
+    {
+      boost::mutex::scoped_lock lock(clients_mutex_);
+      threads.swap(finished_threads_);
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+      // stop() may have joined it already
+      if (threads[i]->joinable())
+        threads[i]->join();
+    }
+  }
+
+  void LocalBufferServer::clientThread(int fd)
+  {
+    // One thread per client, so a lookup blocking on its timeout only delays that client
+    while (processRequest(fd))
+    {
+    }
+
+    // Closed while holding the lock, so accept() cannot hand out fd again before it is removed from the map
+    boost::mutex::scoped_lock lock(clients_mutex_);
+    std::map<int, ThreadPtr>::iterator it = client_threads_.find(fd);
+    finished_threads_.push_back(it->second);
+    client_threads_.erase(it);
+    close(fd);
+  }
+
+  bool LocalBufferServer::processRequest(int fd)
+  {
+    protocol::RequestHeader request;
+    std::string target_frame, source_frame, fixed_frame;
+    if (!protocol::readAll(fd, &request, sizeof(request)) ||
+        !protocol::readString(fd, request.target_frame_length, target_frame) ||
+        !protocol::readString(fd, request.source_frame_length, source_frame) ||
+        !protocol::readString(fd, request.fixed_frame_length, fixed_frame))
+      return false;
+
+    ros::Time target_time(request.target_time_sec, request.target_time_nsec);
+    ros::Time source_time(request.source_time_sec, request.source_time_nsec);
+    ros::Duration timeout(request.timeout_sec, request.timeout_nsec);
+
+    geometry_msgs::TransformStamped transform;
+    uint8_t error = tf2_msgs::TF2Error::NO_ERROR;
+    std::string error_string;
+
+    if (request.op == protocol::CAN_TRANSFORM)
+    {
+      bool can_transform = request.advanced ?
+        buffer_.canTransform(target_frame, target_time, source_frame, source_time, fixed_frame, timeout, &error_string) :
+        buffer_.canTransform(target_frame, source_frame, source_time, timeout, &error_string);
+      if (!can_transform)
+        error = tf2_msgs::TF2Error::TRANSFORM_ERROR;
+    }
+    else
+    {
+      try
+      {
+        transform = request.advanced ?
+          buffer_.lookupTransform(target_frame, target_time, source_frame, source_time, fixed_frame, timeout) :
+          buffer_.lookupTransform(target_frame, source_frame, source_time, timeout);
+      }
+      catch (tf2::ConnectivityException &ex)
+      {
+        error = tf2_msgs::TF2Error::CONNECTIVITY_ERROR;
+        error_string = ex.what();
+      }
+      catch (tf2::LookupException &ex)
+      {
+        error = tf2_msgs::TF2Error::LOOKUP_ERROR;
+        error_string = ex.what();
+      }
+      catch (tf2::ExtrapolationException &ex)
+      {
+        error = tf2_msgs::TF2Error::EXTRAPOLATION_ERROR;
+        error_string = ex.what();
+      }
+      catch (tf2::InvalidArgumentException &ex)
+      {
+        error = tf2_msgs::TF2Error::INVALID_ARGUMENT_ERROR;
+        error_string = ex.what();
+      }
+      catch (tf2::TimeoutException &ex)
+      {
+        error = tf2_msgs::TF2Error::TIMEOUT_ERROR;
+        error_string = ex.what();
+      }
+      catch (tf2::TransformException &ex)
+      {
+        error = tf2_msgs::TF2Error::TRANSFORM_ERROR;
+        error_string = ex.what();
+      }
+    }
+
+    // A longer string would make the client drop the connection instead of reporting the error
+    if (error_string.size() > protocol::MAX_STRING_LENGTH)
+      error_string.resize(protocol::MAX_STRING_LENGTH);
+
+    protocol::ResponseHeader response;
+    memset(&response, 0, sizeof(response));
+    response.error = error;
+    response.frame_id_length = transform.header.frame_id.size();
+    response.child_frame_id_length = transform.child_frame_id.size();
+    response.error_string_length = error_string.size();
+    response.stamp_sec = transform.header.stamp.sec;
+    response.stamp_nsec = transform.header.stamp.nsec;
+    response.translation[0] = transform.transform.translation.x;
+    response.translation[1] = transform.transform.translation.y;
+    response.translation[2] = transform.transform.translation.z;
+    response.rotation[0] = transform.transform.rotation.x;
+    response.rotation[1] = transform.transform.rotation.y;
+    response.rotation[2] = transform.transform.rotation.z;
+    response.rotation[3] = transform.transform.rotation.w;
+
+    // Send the header and strings in one write
+    std::string out(reinterpret_cast<const char*>(&response), sizeof(response));
+    out += transform.header.frame_id;
+    out += transform.child_frame_id;
+    out += error_string;
+    return protocol::writeAll(fd, out.data(), out.size());
+  }
+};
@@ -0,0 +1,112 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <tf2_ros/shared_buffer.h>
+#include <tf2_ros/transform_listener.h>
+
+namespace tf2_ros
+{
+  struct SharedBuffer::Entry
+  {
+    Entry(const ros::Duration& cache_time)
+      : buffer(cache_time)
+      , listener(buffer)
+      , cache_time(cache_time)
+    {
+    }
+
+    Buffer buffer;
+    TransformListener listener;
+    /// Longest history asked for, protected by the registry mutex
+    ros::Duration cache_time;
+  };
+
+  // Function statics are created on first use, so the registry also works from other static initializers
+  SharedBuffer::M_Entry& SharedBuffer::entries()
+  {
+    static M_Entry entries;
+    return entries;
+  }
+
+  boost::mutex& SharedBuffer::entriesMutex()
+  {
+    static boost::mutex mutex;
+    return mutex;
+  }
+
+  boost::shared_ptr<Buffer> SharedBuffer::get(const std::string& name, const ros::Duration& cache_time)
+  {
+    boost::mutex::scoped_lock lock(entriesMutex());
+    boost::weak_ptr<Entry>& weak_entry = entries()[name];
+
+    boost::shared_ptr<Entry> entry = weak_entry.lock();
+    if (!entry)
+    {
+      ROS_DEBUG_NAMED("shared_buffer", "Creating shared tf2 buffer \"%s\" with %f s of history", name.c_str(), cache_time.toSec());
+      entry.reset(new Entry(cache_time));
+      weak_entry = entry;
+    }
+    else if (cache_time > entry->cache_time)
+    {
+      ROS_DEBUG_NAMED("shared_buffer", "Extending the history of shared tf2 buffer \"%s\" to %f s", name.c_str(), cache_time.toSec());
+      entry->cache_time = cache_time;
+      entry->buffer.setCacheLength(cache_time);
+    }
+
+    // Hand out the buffer, while the pointer keeps the whole entry with its listener alive
+    return boost::shared_ptr<Buffer>(entry, &entry->buffer);
+  }
+
+  size_t SharedBuffer::count()
+  {
+    boost::mutex::scoped_lock lock(entriesMutex());
+    M_Entry& all = entries();
+
+    size_t alive = 0;
+    for (M_Entry::iterator it = all.begin(); it != all.end();)
+    {
+      if (it->second.expired())
+      {
+        all.erase(it++);
+      }
+      else
+      {
+        ++alive;
+        ++it;
+      }
+    }
+    return alive;
+  }
+}
@@ -30,7 +30,8 @@
 import rospy
 import tf2_py as tf2
 import tf2_ros
-from tf2_msgs.srv import FrameGraph, FrameGraphResponse
+from tf2_msgs.msg import FrameInfo
+from tf2_msgs.srv import FrameGraph, FrameGraphResponse, FrameInfoGraph, FrameInfoGraphResponse
 import rosgraph.masterapi
 
 class Buffer(tf2.BufferCore, tf2_ros.BufferInterface):
@@ -41,7 +42,7 @@ class Buffer(tf2.BufferCore, tf2_ros.BufferInterface):
 
     Stores known frames and optionally offers a ROS service, "tf2_frames", which responds to client requests
     with a response containing a :class:`tf2_msgs.FrameGraph` representing the relationship of
-    known frames. 
+    known frames, and "tf2_frame_info", which responds with the same information as :class:`tf2_msgs.FrameInfo`.
     """
 
     def __init__(self, cache_time = None, debug = True):
@@ -66,9 +67,13 @@ class Buffer(tf2.BufferCore, tf2_ros.BufferInterface):
                 m.lookupService('~tf2_frames')
             except (rosgraph.masterapi.Error, rosgraph.masterapi.Failure):   
                 self.frame_server = rospy.Service('~tf2_frames', FrameGraph, self.__get_frames)
+                self.frame_info_server = rospy.Service('~tf2_frame_info', FrameInfoGraph, self.__get_frame_info)
 
     def __get_frames(self, req):
-       return FrameGraphResponse(self.all_frames_as_yaml()) 
+        return FrameGraphResponse(self.all_frames_as_yaml())
+
+    def __get_frame_info(self, req):
+        return FrameInfoGraphResponse([FrameInfo(*info) for info in self.all_frames_as_frame_info()])
 
     def lookup_transform(self, target_frame, source_frame, time, timeout=rospy.Duration(0.0)):
         """
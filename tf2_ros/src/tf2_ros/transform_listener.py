@@ -53,8 +53,14 @@ class TransformListener():
         self.buffer = buffer
         self.last_update = rospy.Time.now()
         self.last_update_lock = threading.Lock()
-        self.tf_sub = rospy.Subscriber("/tf", TFMessage, self.callback, queue_size=queue_size, buff_size=buff_size, tcp_nodelay=tcp_nodelay)
-        self.tf_static_sub = rospy.Subscriber("/tf_static", TFMessage, self.static_callback, queue_size=queue_size, buff_size=buff_size, tcp_nodelay=tcp_nodelay)
+        # Buffers backed by tf2.BufferCore can ingest the serialized TFMessage natively,
+        # which avoids building python message objects for every transform.
+        if hasattr(buffer, 'set_transforms_serialized'):
+            msg_type, callback, static_callback = rospy.AnyMsg, self.serialized_callback, self.serialized_static_callback
+        else:
+            msg_type, callback, static_callback = TFMessage, self.callback, self.static_callback
+        self.tf_sub = rospy.Subscriber("/tf", msg_type, callback, queue_size=queue_size, buff_size=buff_size, tcp_nodelay=tcp_nodelay)
+        self.tf_static_sub = rospy.Subscriber("/tf_static", msg_type, static_callback, queue_size=queue_size, buff_size=buff_size, tcp_nodelay=tcp_nodelay)
 
     def __del__(self):
         self.unregister()
@@ -72,8 +78,8 @@ class TransformListener():
         with self.last_update_lock:
             now = rospy.Time.now()
             if now < self.last_update:
-                rospy.logwarn("Detected jump back in time of %fs. Clearing TF buffer." % (self.last_update - now).to_sec())
-                self.buffer.clear()
+                rospy.logwarn("Detected jump back in time of %fs. Clearing TF data after %f." % ((self.last_update - now).to_sec(), now.to_sec()))
+                self.buffer.clear_after(now)
             self.last_update = now
 
     def callback(self, data):
@@ -87,3 +93,13 @@ class TransformListener():
         who = data._connection_header.get('callerid', "default_authority")
         for transform in data.transforms:
             self.buffer.set_transform_static(transform, who)
+
+    def serialized_callback(self, data):
+        self.check_for_reset()
+        who = data._connection_header.get('callerid', "default_authority")
+        self.buffer.set_transforms_serialized(data._buff, who)
+
+    def serialized_static_callback(self, data):
+        self.check_for_reset()
+        who = data._connection_header.get('callerid', "default_authority")
+        self.buffer.set_transforms_serialized(data._buff, who, True)
@@ -31,12 +31,15 @@
 
 #include "tf2_ros/transform_listener.h"
 
+#include <algorithm>
+
 
 using namespace tf2_ros;
 
 
 TransformListener::TransformListener(tf2::BufferCore& buffer, bool spin_thread, ros::TransportHints transport_hints):
-  dedicated_listener_thread_(NULL), buffer_(buffer), using_dedicated_thread_(false), transport_hints_(transport_hints)
+  dedicated_listener_thread_(NULL), buffer_(buffer), using_dedicated_thread_(false), transport_hints_(transport_hints),
+  max_backlog_(0), keep_every_(0)
 {
   if (spin_thread)
     initWithThread();
@@ -51,6 +54,8 @@ TransformListener::TransformListener(tf2::BufferCore& buffer, const ros::NodeHan
 , buffer_(buffer)
 , using_dedicated_thread_(false)
 , transport_hints_(transport_hints)
+, max_backlog_(0)
+, keep_every_(0)
 {
   if (spin_thread)
     initWithThread();
@@ -103,32 +108,158 @@ void TransformListener::static_subscription_callback(const ros::MessageEvent<tf2
 
 void TransformListener::subscription_callback_impl(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt, bool is_static)
 {
-  ros::Time now = ros::Time::now();
+  checkTimeJump(ros::Time::now());
+
+  std::string authority = msg_evt.getPublisherName(); // lookup the authority
+  if (using_dedicated_thread_)
+  {
+    // Inserted once the dedicated thread has drained its queue, so a backlog can be collapsed
+    PendingMessage pending = {msg_evt.getConstMessage(), authority, is_static};
+    pending_.push_back(pending);
+    return;
+  }
+  insertTransforms(msg_evt.getConstMessage()->transforms, authority, is_static);
+};
+
+void TransformListener::checkTimeJump(const ros::Time& now)
+{
   if(now < last_update_){
-    ROS_WARN_STREAM("Detected jump back in time of " << (last_update_ - now).toSec() << "s. Clearing TF buffer.");
-    buffer_.clear();
+    ROS_WARN_STREAM("Detected jump back in time of " << (last_update_ - now).toSec() << "s. Clearing TF data after " << now << ".");
+    // Messages received earlier in this pass go in first, or they would bring back what is cleared
+    insertPending();
+    buffer_.clearAfter(now);
   }
   last_update_ = now;
+}
 
+void TransformListener::insertTransforms(const V_TransformStamped& transforms, const std::string& authority, bool is_static)
+{
+  try
+  {
+    buffer_.setTransforms(transforms, authority, is_static);
+  }
+  
+  catch (tf2::TransformException& ex)
+  {
+    ///\todo Use error reporting
+    std::string temp = ex.what();
+    ROS_ERROR("Failure to set recieved transforms from %s with error: %s\n", authority.c_str(), temp.c_str());
+  }
+}
 
+bool TransformListener::loadHistory(const std::string& server_ns, const std::vector<std::string>& frames,
+                                    ros::Duration history, ros::Duration timeout)
+{
+  ros::ServiceClient client = node_.serviceClient<tf2_msgs::TransformHistory>(server_ns + "/history");
+  if (!client.waitForExistence(timeout))
+  {
+    ROS_WARN("No transform history is available from %s, it did not come up within %f s", client.getService().c_str(), timeout.toSec());
+    return false;
+  }
 
-  const tf2_msgs::TFMessage& msg_in = *(msg_evt.getConstMessage());
-  std::string authority = msg_evt.getPublisherName(); // lookup the authority
-  for (unsigned int i = 0; i < msg_in.transforms.size(); i++)
+  // Anything older than the cache time would be rejected on insertion anyway
+  tf2_msgs::TransformHistory srv;
+  srv.request.frame_ids = frames;
+  srv.request.history = buffer_.getCacheLength();
+  if (!history.isZero() && history < srv.request.history)
+    srv.request.history = history;
+  if (!client.call(srv))
   {
-    try
-    {
-      buffer_.setTransform(msg_in.transforms[i], authority, is_static);
-    }
-    
-    catch (tf2::TransformException& ex)
+    ROS_WARN("Failed to get the transform history from %s", client.getService().c_str());
+    return false;
+  }
+
+  return insertHistory(srv.response.frames, client.getService());
+}
+
+bool TransformListener::insertHistory(const std::vector<tf2_msgs::FrameHistory>& frames, const std::string& authority)
+{
+  size_t samples = 0;
+  for (size_t i = 0; i < frames.size(); ++i)
+    samples += frames[i].stamps.size();
+  ROS_DEBUG("Loading %lu samples of %lu frames from %s", (unsigned long)samples, (unsigned long)frames.size(),
+            authority.c_str());
+  // The subscriptions run while the history is fetched, setFrameHistory leaves the samples they already
+  // received alone
+  return buffer_.setFrameHistory(frames, authority);
+}
+
+void TransformListener::setLoadShedding(unsigned int max_backlog, unsigned int keep_every)
+{
+  boost::mutex::scoped_lock lock(load_shedding_mutex_);
+  max_backlog_ = max_backlog;
+  keep_every_ = keep_every;
+}
+
+void TransformListener::insertPending()
+{
+  if (pending_.empty())
+    return;
+
+  unsigned int max_backlog, keep_every;
+  {
+    boost::mutex::scoped_lock lock(load_shedding_mutex_);
+    max_backlog = max_backlog_;
+    keep_every = keep_every_;
+  }
+
+  if (max_backlog == 0 || pending_.size() <= max_backlog)
+  {
+    for (size_t i = 0; i < pending_.size(); ++i)
+      insertTransforms(pending_[i].message->transforms, pending_[i].authority, pending_[i].is_static);
+  }
+  else
+  {
+    insertCollapsed(keep_every);
+  }
+  pending_.clear();
+}
+
+void TransformListener::insertCollapsed(unsigned int keep_every)
+{
+  for (size_t i = 0; i < pending_.size(); ++i)
+  {
+    if (pending_[i].is_static)
+      insertTransforms(pending_[i].message->transforms, pending_[i].authority, true);
+  }
+
+  // Walk the backlog from the newest sample back, so the first one seen of a frame is its latest
+  samples_per_frame_.clear();
+  size_t received = 0, kept = 0;
+  for (size_t i = pending_.size(); i-- > 0;)
+  {
+    const PendingMessage& pending = pending_[i];
+    if (pending.is_static)
+      continue;
+    const V_TransformStamped& transforms = pending.message->transforms;
+    V_TransformStamped* collapsed = NULL;
+    for (size_t j = transforms.size(); j-- > 0;)
     {
-      ///\todo Use error reporting
-      std::string temp = ex.what();
-      ROS_ERROR("Failure to set recieved transform from %s to %s with error: %s\n", msg_in.transforms[i].child_frame_id.c_str(), msg_in.transforms[i].header.frame_id.c_str(), temp.c_str());
+      ++received;
+      unsigned int older = samples_per_frame_[transforms[j].child_frame_id]++;
+      if (older == 0 || (keep_every && older % keep_every == 0))
+      {
+        if (!collapsed)
+          collapsed = &collapsed_[pending.authority];
+        collapsed->push_back(transforms[j]);
+        ++kept;
+      }
     }
   }
-};
+
+  for (std::map<std::string, V_TransformStamped>::iterator it = collapsed_.begin(); it != collapsed_.end(); ++it)
+  {
+    if (it->second.empty())
+      continue;
+    // Back into the order they were received in, which is the cheap order for the caches
+    std::reverse(it->second.begin(), it->second.end());
+    insertTransforms(it->second, it->first, false);
+    it->second.clear();
+  }
+
+  ROS_WARN_THROTTLE(1.0, "TransformListener fell %lu messages behind, inserted the latest %lu of %lu transforms",
+                    (unsigned long)pending_.size(), (unsigned long)kept, (unsigned long)received);
+}
 
 
 
@@ -29,6 +29,7 @@
 
 #include <gtest/gtest.h>
 #include <tf2_ros/transform_listener.h>
+#include <tf2_ros/shared_buffer.h>
 
 using namespace tf2;
 
@@ -44,6 +45,114 @@ TEST(tf2_ros_transform, transform_listener_transport_hints)
   tf2_ros::TransformListener tfl(buffer, true, ros::TransportHints().tcpNoDelay());
 }
 
+TEST(tf2_ros_transform, shared_buffer)
+{
+  boost::shared_ptr<tf2_ros::Buffer> a = tf2_ros::SharedBuffer::get("", ros::Duration(5.0));
+  boost::shared_ptr<tf2_ros::Buffer> b = tf2_ros::SharedBuffer::get();
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_EQ(ros::Duration(tf2::BufferCore::DEFAULT_CACHE_TIME), a->getCacheLength());
+  EXPECT_TRUE(a->isUsingDedicatedThread());
+
+  // The longest history asked for wins
+  boost::shared_ptr<tf2_ros::Buffer> c = tf2_ros::SharedBuffer::get("", ros::Duration(30.0));
+  EXPECT_EQ(a.get(), c.get());
+  EXPECT_EQ(ros::Duration(30.0), a->getCacheLength());
+
+  boost::shared_ptr<tf2_ros::Buffer> other = tf2_ros::SharedBuffer::get("other");
+  EXPECT_NE(a.get(), other.get());
+  EXPECT_EQ(2u, tf2_ros::SharedBuffer::count());
+
+  other.reset();
+  EXPECT_EQ(1u, tf2_ros::SharedBuffer::count());
+  a.reset();
+  b.reset();
+  c.reset();
+  EXPECT_EQ(0u, tf2_ros::SharedBuffer::count());
+}
+
+static tf2_msgs::TFMessageConstPtr tfMessage(const std::string& parent, const std::string& child, double stamp)
+{
+  boost::shared_ptr<tf2_msgs::TFMessage> message(new tf2_msgs::TFMessage);
+  geometry_msgs::TransformStamped transform;
+  transform.header.frame_id = parent;
+  transform.header.stamp = ros::Time(stamp);
+  transform.child_frame_id = child;
+  transform.transform.rotation.w = 1;
+  message->transforms.push_back(transform);
+  return message;
+}
+
+TEST(tf2_ros_transform, load_shedding)
+{
+  tf2_ros::Buffer buffer;
+  tf2_ros::TransformListener tfl(buffer, false);
+  tf2_ros::TestTransformListener tester;
+
+  // A backlog no longer than max_backlog is inserted whole
+  tfl.setLoadShedding(10, 4);
+  for (int i = 1; i <= 5; ++i)
+    tester._receive(tfl, tfMessage("map", "base_link", i * 0.01), "authority1", false);
+  tester._insertPending(tfl);
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(0.01)));
+
+  // Of a longer one, the latest sample and every 4th older one of each frame are kept
+  buffer.clear();
+  tester._receive(tfl, tfMessage("map", "static_link", 0.01), "authority1", true);
+  for (int i = 1; i <= 20; ++i)
+    tester._receive(tfl, tfMessage("map", "base_link", i * 0.01), "authority1", false);
+  tester._insertPending(tfl);
+  EXPECT_TRUE(buffer.canTransform("map", "static_link", ros::Time(0.2)));
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(0.2)));
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(0.04)));
+  EXPECT_FALSE(buffer.canTransform("map", "base_link", ros::Time(0.03)));
+
+  // Turned off, everything is inserted
+  buffer.clear();
+  tfl.setLoadShedding(0);
+  for (int i = 1; i <= 20; ++i)
+    tester._receive(tfl, tfMessage("map", "base_link", i * 0.01), "authority1", false);
+  tester._insertPending(tfl);
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(0.01)));
+}
+
+TEST(tf2_ros_transform, time_jump_with_pending)
+{
+  tf2_ros::Buffer buffer;
+  tf2_ros::TransformListener tfl(buffer, false);
+  tf2_ros::TestTransformListener tester;
+
+  tester._checkTimeJump(tfl, ros::Time(100.0));
+  tester._receive(tfl, tfMessage("map", "odom", 5.0), "authority1", false);
+  tester._receive(tfl, tfMessage("map", "base_link", 50.0), "authority1", false);
+
+  // Time jumps back while both are still queued, the one from after the jump must not survive it
+  tester._checkTimeJump(tfl, ros::Time(10.0));
+  tester._insertPending(tfl);
+  EXPECT_TRUE(buffer.canTransform("map", "odom", ros::Time(5.0)));
+  EXPECT_FALSE(buffer.canTransform("map", "base_link", ros::Time(50.0)));
+}
+
+TEST(tf2_ros_transform, history_overlaps_live_data)
+{
+  tf2_ros::Buffer server_buffer;
+  for (int i = 1; i <= 10; ++i)
+    server_buffer.setTransform(tfMessage("map", "base_link", i)->transforms[0], "authority1");
+  std::vector<tf2_msgs::FrameHistory> history;
+  server_buffer.getFrameHistory(std::vector<std::string>(), ros::Duration(), history);
+
+  // The newest samples arrived live before the history did
+  tf2_ros::Buffer buffer;
+  tf2_ros::TransformListener tfl(buffer, false);
+  tf2_ros::TestTransformListener tester;
+  for (int i = 9; i <= 11; ++i)
+    tester._receive(tfl, tfMessage("map", "base_link", i), "authority1", false);
+  tester._insertPending(tfl);
+
+  EXPECT_TRUE(tester._insertHistory(tfl, history, "server/history"));
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(1)));
+  EXPECT_TRUE(buffer.canTransform("map", "base_link", ros::Time(11)));
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   ros::init(argc, argv, "transform_listener_unittest");
@@ -0,0 +1,127 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/local_buffer_client.h>
+#include <tf2_ros/local_buffer_server.h>
+
+#include <ros/ros.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+/* Compares lookups on an in-process Buffer, which is what every process running its own
+ * TransformListener does, with lookups through a LocalBufferClient attached to a shared
+ * LocalBufferServer. Runs without a ROS master.
+ *
+ * usage: local_buffer_server_benchmark [num_levels] [num_clients]
+ */
+
+static const int NUM_LOOKUPS = 20000;
+
+void lookupLoop(const tf2_ros::BufferInterface& buffer, const std::string& target, const std::string& source, int count)
+{
+  for (int i = 0; i < count; ++i)
+    buffer.lookupTransform(target, source, ros::Time(1.5), ros::Duration(0));
+}
+
+void clientLoop(const std::string& socket_path, const std::string& target, const std::string& source, int count)
+{
+  tf2_ros::LocalBufferClient client(socket_path);
+  client.waitForServer();
+  lookupLoop(client, target, source, count);
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int num_levels = 10;
+  if (argc > 1)
+    num_levels = boost::lexical_cast<unsigned int>(argv[1]);
+  unsigned int num_clients = 4;
+  if (argc > 2)
+    num_clients = boost::lexical_cast<unsigned int>(argv[2]);
+
+  ros::Time::init();
+
+  tf2_ros::Buffer buffer;
+  geometry_msgs::TransformStamped t;
+  t.transform.translation.x = 1;
+  t.transform.rotation.w = 1.0;
+  for (unsigned int i = 0; i < num_levels; ++i)
+  {
+    t.header.frame_id = i == 0 ? "root" : boost::lexical_cast<std::string>(i - 1);
+    t.child_frame_id = boost::lexical_cast<std::string>(i);
+    for (int stamp = 1; stamp <= 2; ++stamp)
+    {
+      t.header.stamp = ros::Time(stamp);
+      buffer.setTransform(t, "me");
+    }
+  }
+  std::string leaf = boost::lexical_cast<std::string>(num_levels - 1);
+
+  std::string socket_path = "/tmp/tf2_local_buffer_benchmark_" + boost::lexical_cast<std::string>(getpid());
+  tf2_ros::LocalBufferServer server(buffer, socket_path);
+  if (!server.start())
+    return 1;
+
+  ros::WallTime start = ros::WallTime::now();
+  lookupLoop(buffer, leaf, "root", NUM_LOOKUPS);
+  double in_process = (ros::WallTime::now() - start).toSec();
+  printf("in-process Buffer:      %.3f us per lookup\n", in_process / NUM_LOOKUPS * 1e6);
+
+  {
+    tf2_ros::LocalBufferClient client(socket_path);
+    client.waitForServer();
+    start = ros::WallTime::now();
+    lookupLoop(client, leaf, "root", NUM_LOOKUPS);
+    double local = (ros::WallTime::now() - start).toSec();
+    printf("LocalBufferClient:      %.3f us per lookup (round trip latency)\n", local / NUM_LOOKUPS * 1e6);
+  }
+
+  boost::thread_group clients;
+  start = ros::WallTime::now();
+  for (unsigned int i = 0; i < num_clients; ++i)
+    clients.create_thread(boost::bind(&clientLoop, socket_path, leaf, std::string("root"), NUM_LOOKUPS));
+  clients.join_all();
+  double aggregate = (ros::WallTime::now() - start).toSec();
+  printf("%u LocalBufferClients:   %.0f lookups per second aggregate\n", num_clients, num_clients * NUM_LOOKUPS / aggregate);
+
+  server.stop();
+  return 0;
+}
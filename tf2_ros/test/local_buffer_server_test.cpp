@@ -0,0 +1,165 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2009, Willow Garage, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/local_buffer_client.h>
+#include <tf2_ros/local_buffer_server.h>
+
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <string>
+#include <unistd.h>
+
+// Runs without a ROS master
+
+static const double EPS = 1e-6;
+
+class LocalBufferServerTest : public ::testing::Test
+{
+protected:
+  LocalBufferServerTest()
+  : socket_path_("/tmp/tf2_local_buffer_test_" + boost::lexical_cast<std::string>(getpid()))
+  {
+    // Timeouts are only honoured with a dedicated thread
+    buffer_.setUsingDedicatedThread(true);
+
+    geometry_msgs::TransformStamped t;
+    t.header.frame_id = "root";
+    t.child_frame_id = "child";
+    t.transform.translation.x = 1;
+    t.transform.rotation.w = 1;
+    t.header.stamp = ros::Time(1.0);
+    buffer_.setTransform(t, "me");
+    t.transform.translation.x = 3;
+    t.header.stamp = ros::Time(2.0);
+    buffer_.setTransform(t, "me");
+
+    t.header.frame_id = "other_root";
+    t.child_frame_id = "other_child";
+    buffer_.setTransform(t, "me");
+  }
+
+  tf2_ros::Buffer buffer_;
+  std::string socket_path_;
+};
+
+TEST_F(LocalBufferServerTest, lookupTransform)
+{
+  tf2_ros::LocalBufferServer server(buffer_, socket_path_);
+  ASSERT_TRUE(server.start());
+  tf2_ros::LocalBufferClient client(socket_path_);
+  ASSERT_TRUE(client.waitForServer(ros::WallDuration(5.0)));
+
+  geometry_msgs::TransformStamped t = client.lookupTransform("root", "child", ros::Time(1.5));
+  EXPECT_EQ("root", t.header.frame_id);
+  EXPECT_EQ("child", t.child_frame_id);
+  EXPECT_EQ(ros::Time(1.5), t.header.stamp);
+  EXPECT_NEAR(2.0, t.transform.translation.x, EPS);
+  EXPECT_NEAR(1.0, t.transform.rotation.w, EPS);
+
+  t = client.lookupTransform("child", ros::Time(1.0), "child", ros::Time(2.0), "root");
+  EXPECT_NEAR(2.0, t.transform.translation.x, EPS);
+}
+
+TEST_F(LocalBufferServerTest, canTransform)
+{
+  tf2_ros::LocalBufferServer server(buffer_, socket_path_);
+  ASSERT_TRUE(server.start());
+  tf2_ros::LocalBufferClient client(socket_path_);
+
+  std::string error;
+  EXPECT_TRUE(client.canTransform("root", "child", ros::Time(1.5), ros::Duration(0), &error));
+  EXPECT_TRUE(client.canTransform("child", ros::Time(1.0), "child", ros::Time(2.0), "root"));
+  EXPECT_FALSE(client.canTransform("root", "other_child", ros::Time(2.0), ros::Duration(0), &error));
+  EXPECT_FALSE(error.empty());
+  // Blocks on the server side for the timeout
+  ros::WallTime start = ros::WallTime::now();
+  EXPECT_FALSE(client.canTransform("root", "child", ros::Time(3.0), ros::Duration(0.2), &error));
+  EXPECT_GE((ros::WallTime::now() - start).toSec(), 0.15);
+}
+
+TEST_F(LocalBufferServerTest, errors)
+{
+  tf2_ros::LocalBufferServer server(buffer_, socket_path_);
+  ASSERT_TRUE(server.start());
+  tf2_ros::LocalBufferClient client(socket_path_);
+
+  EXPECT_THROW(client.lookupTransform("root", "missing", ros::Time(1.5)), tf2::LookupException);
+  EXPECT_THROW(client.lookupTransform("root", "other_child", ros::Time(2.0)), tf2::ConnectivityException);
+  EXPECT_THROW(client.lookupTransform("root", "child", ros::Time(3.0)), tf2::ExtrapolationException);
+  EXPECT_THROW(client.lookupTransform("/root", "child", ros::Time(1.5)), tf2::InvalidArgumentException);
+
+  // The longest frame id a request may carry, the error message quoting it is longer still
+  std::string long_frame(65536, 'a');
+  EXPECT_THROW(client.lookupTransform("root", long_frame, ros::Time(1.5)), tf2::LookupException);
+
+  // The connection is still usable after errors
+  EXPECT_NEAR(2.0, client.lookupTransform("root", "child", ros::Time(1.5)).transform.translation.x, EPS);
+}
+
+TEST_F(LocalBufferServerTest, reconnect)
+{
+  tf2_ros::LocalBufferClient client(socket_path_);
+  {
+    tf2_ros::LocalBufferServer server(buffer_, socket_path_);
+    ASSERT_TRUE(server.start());
+    EXPECT_TRUE(client.canTransform("root", "child", ros::Time(1.5)));
+  }
+
+  // Without a server the client reports it cannot be reached
+  EXPECT_THROW(client.lookupTransform("root", "child", ros::Time(1.5)), tf2::TransformException);
+
+  // The client reconnects to a restarted server on its next query
+  tf2_ros::LocalBufferServer server(buffer_, socket_path_);
+  ASSERT_TRUE(server.start());
+  EXPECT_NEAR(2.0, client.lookupTransform("root", "child", ros::Time(1.5)).transform.translation.x, EPS);
+
+  // Clients coming and going one after the other are all served
+  for (int i = 0; i < 100; ++i)
+  {
+    tf2_ros::LocalBufferClient short_lived(socket_path_);
+    EXPECT_TRUE(short_lived.canTransform("root", "child", ros::Time(1.5)));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+  return RUN_ALL_TESTS();
+}
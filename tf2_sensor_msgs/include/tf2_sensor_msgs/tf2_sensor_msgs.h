@@ -36,6 +36,11 @@
 #include <Eigen/Eigen>
 #include <Eigen/Geometry>
 
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
 namespace tf2
 {
 
@@ -91,6 +96,117 @@ void doTransform(const sensor_msgs::PointCloud2 &p_in, sensor_msgs::PointCloud2
     *z_out = point.z();
   }
 }
+
+/** \brief Keeps the points inside an axis aligned box, for doTransformAndCrop.
+ * The bounds are in the target frame and inclusive. Points with a NaN coordinate are never inside.
+ */
+struct CropBox
+{
+  CropBox(float min_x, float min_y, float min_z, float max_x, float max_y, float max_z)
+  : min_x(min_x), min_y(min_y), min_z(min_z), max_x(max_x), max_y(max_y), max_z(max_z)
+  {
+  }
+
+  bool operator()(float x, float y, float z) const
+  {
+    return x >= min_x && x <= max_x && y >= min_y && y <= max_y && z >= min_z && z <= max_z;
+  }
+
+  float min_x, min_y, min_z, max_x, max_y, max_z;
+};
+
+/** \brief Keeps the points whose distance from the origin of the target frame is within [min_range, max_range],
+ * for doTransformAndCrop. Points with a NaN coordinate are never within range.
+ */
+struct CropRange
+{
+  CropRange(float min_range, float max_range)
+  : min_squared(min_range * min_range), max_squared(max_range * max_range)
+  {
+  }
+
+  bool operator()(float x, float y, float z) const
+  {
+    float squared = x * x + y * y + z * z;
+    return squared >= min_squared && squared <= max_squared;
+  }
+
+  float min_squared, max_squared;
+};
+
+/** \brief Transform a PointCloud2 and keep only the points for which keep returns true, in a single pass.
+ * Cheaper than doTransform followed by a crop: every point is read once, and only the points which are
+ * kept are written, packed into an unorganized (height 1) cloud. All fields of the kept points are
+ * carried over in their original order.
+ * \param p_in The cloud to transform, with float32 x, y and z fields
+ * \param p_out The transformed points which were kept, may be p_in
+ * \param t_in The transform to apply, its header becomes the header of p_out
+ * \param keep Called as keep(x, y, z) with the coordinates in the target frame, e.g. CropBox or CropRange
+ */
+template <class Predicate>
+void doTransformAndCrop(const sensor_msgs::PointCloud2& p_in, sensor_msgs::PointCloud2& p_out,
+                        const geometry_msgs::TransformStamped& t_in, const Predicate& keep)
+{
+  if (&p_in == &p_out)
+  {
+    // The points are read from the data being replaced, so crop into a separate cloud
+    sensor_msgs::PointCloud2 cropped;
+    doTransformAndCrop(p_in, cropped, t_in, keep);
+    std::swap(p_out, cropped);
+    return;
+  }
+
+  Eigen::Transform<float,3,Eigen::Isometry> t = Eigen::Translation3f(t_in.transform.translation.x, t_in.transform.translation.y,
+                                                                     t_in.transform.translation.z) * Eigen::Quaternion<float>(
+                                                                     t_in.transform.rotation.w, t_in.transform.rotation.x,
+                                                                     t_in.transform.rotation.y, t_in.transform.rotation.z);
+
+  uint32_t offsets[3];
+  const char* names[3] = {"x", "y", "z"};
+  for (int i = 0; i < 3; ++i)
+  {
+    size_t field = 0;
+    while (field < p_in.fields.size() && p_in.fields[field].name != names[i])
+      ++field;
+    if (field == p_in.fields.size())
+      throw std::runtime_error(std::string("Field ") + names[i] + " does not exist");
+    offsets[i] = p_in.fields[field].offset;
+  }
+
+  // Only the metadata is copied, the data is filled with the kept points below
+  p_out.header = t_in.header;
+  p_out.fields = p_in.fields;
+  p_out.is_bigendian = p_in.is_bigendian;
+  p_out.point_step = p_in.point_step;
+  p_out.is_dense = p_in.is_dense;
+  p_out.data.clear();
+  // Room for every point, so appending never regrows. The capacity stays with p_out and is reused when
+  // the same p_out is passed again.
+  p_out.data.reserve(p_in.data.size());
+
+  const uint32_t point_step = p_in.point_step;
+  const size_t count = point_step ? p_in.data.size() / point_step : 0;
+  const uint8_t* in = p_in.data.empty() ? NULL : &p_in.data[0];
+  for (size_t i = 0; i < count; ++i, in += point_step)
+  {
+    float xyz[3];
+    for (int j = 0; j < 3; ++j)
+      memcpy(&xyz[j], in + offsets[j], sizeof(float));
+    Eigen::Vector3f point = t * Eigen::Vector3f(xyz[0], xyz[1], xyz[2]);
+    if (!keep(point.x(), point.y(), point.z()))
+      continue;
+
+    size_t out = p_out.data.size();
+    p_out.data.insert(p_out.data.end(), in, in + point_step);
+    for (int j = 0; j < 3; ++j)
+      memcpy(&p_out.data[out + offsets[j]], &point[j], sizeof(float));
+  }
+
+  p_out.height = 1;
+  p_out.width = count ? p_out.data.size() / point_step : 0;
+  p_out.row_step = p_out.width * point_step;
+}
+
 inline
 sensor_msgs::PointCloud2 toMsg(const sensor_msgs::PointCloud2 &in)
 {
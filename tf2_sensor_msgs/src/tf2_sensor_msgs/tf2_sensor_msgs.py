@@ -25,11 +25,14 @@
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 # POSSIBILITY OF SUCH DAMAGE.
 
-from sensor_msgs.msg import PointCloud2
+import sys
+
+from sensor_msgs.msg import PointCloud2, PointField
 from sensor_msgs.point_cloud2 import read_points, create_cloud
 import PyKDL
 import rospy
 import tf2_ros
+from tf2_py import do_transform_cloud_data
 
 def to_msg_msg(msg):
     return msg
@@ -48,8 +51,31 @@ def transform_to_kdl(t):
                                     t.transform.translation.y, 
                                     t.transform.translation.z))
 
-# PointStamped
+def xyz_float32_offsets(cloud):
+    """
+    Return the byte offsets of the x, y and z fields if they are all native endian FLOAT32, else None.
+    """
+    if cloud.is_bigendian != (sys.byteorder == 'big'):
+        return None
+    offsets = {}
+    for field in cloud.fields:
+        if field.name in ('x', 'y', 'z') and field.datatype == PointField.FLOAT32 and field.count == 1:
+            offsets[field.name] = field.offset
+    if len(offsets) != 3:
+        return None
+    return (offsets['x'], offsets['y'], offsets['z'])
+
+# PointCloud2
 def do_transform_cloud(cloud, transform):
+    offsets = xyz_float32_offsets(cloud)
+    if offsets is not None:
+        # Common case: rewrite the xyz floats natively and keep the cloud layout
+        res = PointCloud2(header=transform.header, height=cloud.height, width=cloud.width, fields=cloud.fields,
+                          is_bigendian=cloud.is_bigendian, point_step=cloud.point_step, row_step=cloud.row_step,
+                          is_dense=cloud.is_dense)
+        res.data = do_transform_cloud_data(cloud, offsets, transform)
+        return res
+
     t_kdl = transform_to_kdl(transform)
     points_out = []
     for p_in in read_points(cloud):
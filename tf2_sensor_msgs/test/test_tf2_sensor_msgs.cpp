@@ -33,6 +33,7 @@
 #include <tf2_ros/transform_listener.h>
 #include <ros/ros.h>
 #include <gtest/gtest.h>
+#include <cmath>
 #include <tf2_ros/buffer.h>
 
 tf2_ros::Buffer* tf_buffer;
@@ -77,6 +78,80 @@ TEST(Tf2Sensor, PointCloud2)
   EXPECT_NEAR(*iter_z_advanced, 27, EPS);
 }
 
+TEST(Tf2Sensor, PointCloud2TransformAndCrop)
+{
+  sensor_msgs::PointCloud2 cloud;
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(2, "xyz", "rgb");
+  modifier.resize(4);
+
+  const float points[4][4] = {{1, 2, 3, 0.5}, {0, 0, 0, 1.5}, {-5, 0, 0, 2.5}, {NAN, 0, 0, 3.5}};
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  sensor_msgs::PointCloud2Iterator<float> iter_rgb(cloud, "rgb");
+  for (int i = 0; i < 4; ++i, ++iter_x, ++iter_y, ++iter_z, ++iter_rgb)
+  {
+    *iter_x = points[i][0];
+    *iter_y = points[i][1];
+    *iter_z = points[i][2];
+    *iter_rgb = points[i][3];
+  }
+
+  geometry_msgs::TransformStamped t;
+  t.transform.translation.x = 10;
+  t.transform.translation.y = 20;
+  t.transform.translation.z = 30;
+  t.transform.rotation.x = 1;
+  t.transform.rotation.w = 0;
+  t.header.stamp = ros::Time(2.0);
+  t.header.frame_id = "B";
+
+  // box, keeps the first two points
+  sensor_msgs::PointCloud2 cloud_box;
+  tf2::doTransformAndCrop(cloud, cloud_box, t, tf2::CropBox(9, 15, 20, 12, 25, 35));
+  EXPECT_EQ("B", cloud_box.header.frame_id);
+  ASSERT_EQ(2u, cloud_box.width);
+  EXPECT_EQ(1u, cloud_box.height);
+  EXPECT_EQ(cloud_box.width * cloud_box.point_step, cloud_box.row_step);
+  EXPECT_EQ(cloud_box.row_step, cloud_box.data.size());
+  sensor_msgs::PointCloud2ConstIterator<float> box_x(cloud_box, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> box_y(cloud_box, "y");
+  sensor_msgs::PointCloud2ConstIterator<float> box_z(cloud_box, "z");
+  sensor_msgs::PointCloud2ConstIterator<float> box_rgb(cloud_box, "rgb");
+  EXPECT_NEAR(*box_x, 11, EPS);
+  EXPECT_NEAR(*box_y, 18, EPS);
+  EXPECT_NEAR(*box_z, 27, EPS);
+  EXPECT_EQ(0.5, *box_rgb);
+  ++box_x; ++box_y; ++box_z; ++box_rgb;
+  EXPECT_NEAR(*box_x, 10, EPS);
+  EXPECT_NEAR(*box_y, 20, EPS);
+  EXPECT_NEAR(*box_z, 30, EPS);
+  EXPECT_EQ(1.5, *box_rgb);
+
+  // range, keeps only the third point
+  sensor_msgs::PointCloud2 cloud_range;
+  tf2::doTransformAndCrop(cloud, cloud_range, t, tf2::CropRange(34.5, 37));
+  ASSERT_EQ(1u, cloud_range.width);
+  sensor_msgs::PointCloud2ConstIterator<float> range_x(cloud_range, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> range_rgb(cloud_range, "rgb");
+  EXPECT_NEAR(*range_x, 5, EPS);
+  EXPECT_EQ(2.5, *range_rgb);
+
+  // nothing survives
+  sensor_msgs::PointCloud2 cloud_empty;
+  tf2::doTransformAndCrop(cloud, cloud_empty, t, tf2::CropBox(0, 0, 0, 1, 1, 1));
+  EXPECT_EQ(0u, cloud_empty.width);
+  EXPECT_TRUE(cloud_empty.data.empty());
+
+  // in place, like doTransform
+  sensor_msgs::PointCloud2 cloud_in_place = cloud;
+  tf2::doTransformAndCrop(cloud_in_place, cloud_in_place, t, tf2::CropBox(9, 15, 20, 12, 25, 35));
+  EXPECT_EQ("B", cloud_in_place.header.frame_id);
+  ASSERT_EQ(2u, cloud_in_place.width);
+  EXPECT_EQ(cloud_box.data, cloud_in_place.data);
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   ros::init(argc, argv, "test");
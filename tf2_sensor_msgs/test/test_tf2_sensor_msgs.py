@@ -47,6 +47,19 @@ class PointCloudConversions(unittest.TestCase):
         assert(expected_coordinates == new_points)
         assert(old_data == self.point_cloud_in.data)  # checking no modification in input cloud
 
+    def test_organized_transform(self):
+        # two rows of one point each, with padding at the end of every row
+        self.point_cloud_in.height = 2
+        self.point_cloud_in.width = 1
+        self.point_cloud_in.row_step = self.point_cloud_in.point_step + 4
+        self.point_cloud_in.data = struct.pack('3fi3fi', 1, 2, 0, 0, 10, 20, 30, 0)
+        point_cloud_transformed = tf2_sensor_msgs.do_transform_cloud(self.point_cloud_in, self.transform_translate_xyz_300)
+
+        self.assertEqual(2, point_cloud_transformed.height)
+        self.assertEqual(self.point_cloud_in.row_step, point_cloud_transformed.row_step)
+        new_points = list(point_cloud2.read_points(point_cloud_transformed))
+        self.assertEqual([(301, 302, 300), (310, 320, 330)], new_points)
+
 
 ## A simple unit test for tf2_sensor_msgs.do_transform_cloud (multi channel version)
 class PointCloudConversionsMultichannel(unittest.TestCase):
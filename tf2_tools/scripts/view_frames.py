@@ -30,9 +30,8 @@
 
 import rospy
 import tf2_py as tf2
-import yaml
 import subprocess
-from tf2_msgs.srv import FrameGraph
+from tf2_msgs.srv import FrameInfoGraph
 import tf2_ros
 
 def main():
@@ -46,13 +45,26 @@ def main():
     rospy.sleep(5.0)
 
     rospy.loginfo('Generating graph in frames.pdf file...')
-    rospy.wait_for_service('~tf2_frames')
-    srv = rospy.ServiceProxy('~tf2_frames', FrameGraph)
-    data = yaml.safe_load(srv().frame_yaml)
+    rospy.wait_for_service('~tf2_frame_info')
+    srv = rospy.ServiceProxy('~tf2_frame_info', FrameInfoGraph)
+    data = frames_as_dict(srv().frames)
     with open('frames.gv', 'w') as f:
         f.write(generate_dot(data))
     subprocess.Popen('dot -Tpdf frames.gv -o frames.pdf'.split(' ')).communicate()
 
+def frames_as_dict(frames):
+    data = {}
+    for info in frames:
+        data[info.frame_id] = {
+            'parent': info.parent_id,
+            'broadcaster': info.authority,
+            'rate': round(info.rate, 3),
+            'buffer_length': info.buffer_length.to_sec(),
+            'most_recent_transform': info.most_recent_transform.to_sec(),
+            'oldest_transform': info.oldest_transform.to_sec(),
+        }
+    return data
+
 def generate_dot(data):
     if len(data) == 0:
         return 'digraph G { "No tf data received" }'
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+#include <tf2_msgs/TFMessage.h>
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+/** \brief Running statistics with a fixed log-spaced histogram.
+ * Adding a sample is O(1) and allocation free, so it keeps up with high rate /tf streams.
+ */
+class Statistics
+{
+public:
+  static const unsigned int NUM_BUCKETS = 12;
+
+  Statistics()
+  : count_(0), mean_(0.0), m2_(0.0), max_(0.0)
+  {
+    std::fill(buckets_, buckets_ + NUM_BUCKETS, 0);
+  }
+
+  void add(double value)
+  {
+    // Welford's online mean and variance
+    ++count_;
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (value - mean_);
+    max_ = std::max(max_, value);
+    ++buckets_[bucket(value)];
+  }
+
+  unsigned long count() const { return count_; }
+  double mean() const { return mean_; }
+  double max() const { return max_; }
+  double stddev() const { return count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0.0; }
+
+  /** \brief Upper bound of the histogram bucket holding the given quantile */
+  double quantile(double q) const
+  {
+    unsigned long target = (unsigned long)std::ceil(q * count_);
+    unsigned long seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+      seen += buckets_[i];
+      if (seen >= target && seen > 0)
+        return (i + 1 < NUM_BUCKETS) ? bucketLimit(i) : max_;
+    }
+    return max_;
+  }
+
+  std::string histogram() const
+  {
+    std::string out;
+    char str[32];
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+      snprintf(str, sizeof(str), "%s%lu", i ? " " : "", buckets_[i]);
+      out += str;
+    }
+    return out;
+  }
+
+  static double bucketLimit(unsigned int i)
+  {
+    // 1ms, 2ms, 5ms, 10ms, ... 100s
+    static const double limits[NUM_BUCKETS - 1] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 100.0};
+    return limits[i];
+  }
+
+private:
+  unsigned int bucket(double value) const
+  {
+    unsigned int i = 0;
+    while (i + 1 < NUM_BUCKETS && value >= bucketLimit(i))
+      ++i;
+    return i;
+  }
+
+  unsigned long count_;
+  double mean_;
+  double m2_;
+  double max_;
+  unsigned long buckets_[NUM_BUCKETS];
+};
+
+/** \brief Delay and arrival statistics for one frame, or one authority */
+struct SourceStatistics
+{
+  SourceStatistics() : is_static(false) {}
+
+  void add(const ros::Time& stamp, const ros::Time& receipt_time)
+  {
+    delay.add((receipt_time - stamp).toSec());
+    if (!last_receipt_time.isZero())
+    {
+      period.add((receipt_time - last_receipt_time).toSec());
+    }
+    last_receipt_time = receipt_time;
+  }
+
+  Statistics delay;
+  Statistics period;
+  ros::Time last_receipt_time;
+  std::string authority;
+  /// Seen on /tf_static, whose latched stamps say nothing about delay or rate
+  bool is_static;
+};
+
+class TFMonitor
+{
+public:
+  TFMonitor(const std::string& source_frame, const std::string& target_frame)
+  : source_frame_(source_frame)
+  , target_frame_(target_frame)
+  , listener_(buffer_)
+  {
+    subscriber_tf_ = node_.subscribe<tf2_msgs::TFMessage>("/tf", 100, boost::bind(&TFMonitor::callback, this, _1, false));
+    subscriber_tf_static_ = node_.subscribe<tf2_msgs::TFMessage>("/tf_static", 100, boost::bind(&TFMonitor::callback, this, _1, true));
+    start_time_ = ros::Time::now();
+  }
+
+  void callback(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt, bool is_static)
+  {
+    const tf2_msgs::TFMessage& msg = *(msg_evt.getConstMessage());
+    const std::string& authority = msg_evt.getPublisherName();
+    ros::Time receipt_time = msg_evt.getReceiptTime();
+
+    SourceStatistics& authority_stats = authorities_[authority];
+    for (unsigned int i = 0; i < msg.transforms.size(); i++)
+    {
+      const geometry_msgs::TransformStamped& transform = msg.transforms[i];
+      SourceStatistics& frame_stats = frames_[transform.child_frame_id];
+      frame_stats.authority = authority;
+      if (is_static)
+        frame_stats.is_static = true;
+      else
+        frame_stats.add(transform.header.stamp, receipt_time);
+    }
+    if (is_static)
+      authority_stats.is_static = true;
+    else if (!msg.transforms.empty())
+      authority_stats.add(msg.transforms[0].header.stamp, receipt_time);
+  }
+
+  void updateChain()
+  {
+    if (source_frame_.empty() || target_frame_.empty())
+      return;
+
+    try
+    {
+      if (chain_.empty())
+      {
+        buffer_._chainAsVector(target_frame_, ros::Time(), source_frame_, ros::Time(), target_frame_, chain_);
+      }
+      geometry_msgs::TransformStamped transform = buffer_.lookupTransform(target_frame_, source_frame_, ros::Time());
+      chain_delay_.add((ros::Time::now() - transform.header.stamp).toSec());
+    }
+    catch (tf2::TransformException& ex)
+    {
+      ROS_WARN_THROTTLE(1.0, "tf2_monitor could not look up %s -> %s: %s", source_frame_.c_str(), target_frame_.c_str(), ex.what());
+    }
+  }
+
+  void print() const
+  {
+    double elapsed = (ros::Time::now() - start_time_).toSec();
+
+    printf("\n\nRESULTS: for all frames over %.1f s\n", elapsed);
+    printf("Histogram buckets end at:");
+    for (unsigned int i = 0; i + 1 < Statistics::NUM_BUCKETS; ++i)
+      printf(" %gs", Statistics::bucketLimit(i));
+    printf("\n");
+
+    if (!chain_.empty())
+    {
+      printf("Chain from %s to %s:", source_frame_.c_str(), target_frame_.c_str());
+      for (unsigned int i = 0; i < chain_.size(); ++i)
+        printf(" %s", chain_[i].c_str());
+      printf("\nChain delay: average %.4f p99 %.4f max %.4f [%s]\n",
+             chain_delay_.mean(), chain_delay_.quantile(0.99), chain_delay_.max(), chain_delay_.histogram().c_str());
+    }
+
+    printf("Frames:\n");
+    printStatistics(frames_, elapsed, true);
+    printf("\nAll Broadcasters:\n");
+    printStatistics(authorities_, elapsed, false);
+  }
+
+private:
+  typedef std::map<std::string, SourceStatistics> M_SourceStatistics;
+
+  void printStatistics(const M_SourceStatistics& stats, double elapsed, bool print_authority) const
+  {
+    for (M_SourceStatistics::const_iterator it = stats.begin(); it != stats.end(); ++it)
+    {
+      const SourceStatistics& s = it->second;
+      if (s.is_static && s.delay.count() == 0)
+      {
+        printf("%s: %s%s%s static\n", print_authority ? "Frame" : "Node", it->first.c_str(),
+               print_authority ? " published by " : "", print_authority ? s.authority.c_str() : "");
+        continue;
+      }
+      printf("%s: %s%s%s rate %.3f Hz, delay average %.4f p99 %.4f max %.4f [%s], jitter %.4f max gap %.4f\n",
+             print_authority ? "Frame" : "Node", it->first.c_str(),
+             print_authority ? " published by " : "", print_authority ? s.authority.c_str() : "",
+             s.delay.count() / std::max(elapsed, 0.0001),
+             s.delay.mean(), s.delay.quantile(0.99), s.delay.max(), s.delay.histogram().c_str(),
+             s.period.stddev(), s.period.max());
+    }
+  }
+
+  std::string source_frame_, target_frame_;
+  ros::NodeHandle node_;
+  ros::Subscriber subscriber_tf_, subscriber_tf_static_;
+  tf2_ros::Buffer buffer_;
+  tf2_ros::TransformListener listener_;
+
+  ros::Time start_time_;
+  M_SourceStatistics frames_;
+  M_SourceStatistics authorities_;
+  std::vector<std::string> chain_;
+  Statistics chain_delay_;
+};
+
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "tf2_monitor", ros::init_options::AnonymousName);
+
+  std::string source_frame, target_frame;
+  if (argc == 3)
+  {
+    source_frame = argv[1];
+    target_frame = argv[2];
+  }
+  else if (argc != 1)
+  {
+    printf("Usage: tf2_monitor [source_frame target_frame]\n");
+    printf("Reports per frame and per broadcaster delay, rate and jitter of /tf, and lists the frames of /tf_static.\n");
+    printf("If two frames are given, also reports the delay of the chain between them.\n");
+    return -1;
+  }
+
+  ros::NodeHandle nh("~");
+  double print_period;
+  nh.param("print_period", print_period, 1.0);
+
+  TFMonitor monitor(source_frame, target_frame);
+
+  ros::WallTime next_print = ros::WallTime::now() + ros::WallDuration(print_period);
+  ros::Rate rate(100);
+  while (ros::ok())
+  {
+    ros::spinOnce();
+    monitor.updateChain();
+    if (ros::WallTime::now() >= next_print)
+    {
+      monitor.print();
+      next_print += ros::WallDuration(print_period);
+    }
+    rate.sleep();
+  }
+
+  return 0;
+}
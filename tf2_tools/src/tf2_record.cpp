@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tf_log.h"
+
+#include <tf2_msgs/TFMessage.h>
+#include <ros/ros.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/** \brief Writes /tf and /tf_static to a binary log, see tf_log.h for the format */
+class TFRecorder
+{
+public:
+  TFRecorder(FILE* file)
+  : file_(file)
+  , messages_(0)
+  , transforms_(0)
+  , bytes_(0)
+  {
+    tf2_tools::FileHeader header;
+    memcpy(header.magic, tf2_tools::LOG_MAGIC, sizeof(header.magic));
+    header.version = tf2_tools::LOG_VERSION;
+    header.reserved = 0;
+    write(&header, sizeof(header));
+
+    subscriber_tf_ = node_.subscribe("/tf", 1000, &TFRecorder::callback, this);
+    subscriber_tf_static_ = node_.subscribe("/tf_static", 1000, &TFRecorder::staticCallback, this);
+  }
+
+  void callback(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt)
+  {
+    record(msg_evt, false);
+  }
+
+  void staticCallback(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt)
+  {
+    record(msg_evt, true);
+  }
+
+  void printSummary() const
+  {
+    printf("Recorded %lu messages with %lu transforms of %lu frames and authorities, %lu bytes\n",
+           messages_, transforms_, (unsigned long)names_.size(), bytes_);
+  }
+
+private:
+  void record(const ros::MessageEvent<tf2_msgs::TFMessage const>& msg_evt, bool is_static)
+  {
+    const tf2_msgs::TFMessage& msg = *(msg_evt.getConstMessage());
+
+    // Names go first, so a reader knows every id by the time it is used
+    tf2_tools::MessageRecord message;
+    message.receipt_time = msg_evt.getReceiptTime().toNSec();
+    message.authority = nameId(msg_evt.getPublisherName());
+    message.count = msg.transforms.size();
+    message.is_static = is_static;
+    memset(message.reserved, 0, sizeof(message.reserved));
+
+    transforms_buffer_.resize(msg.transforms.size());
+    for (size_t i = 0; i < msg.transforms.size(); ++i)
+    {
+      const geometry_msgs::TransformStamped& in = msg.transforms[i];
+      tf2_tools::TransformRecord& out = transforms_buffer_[i];
+      out.stamp = in.header.stamp.toNSec();
+      out.parent = nameId(in.header.frame_id);
+      out.child = nameId(in.child_frame_id);
+      out.translation[0] = in.transform.translation.x;
+      out.translation[1] = in.transform.translation.y;
+      out.translation[2] = in.transform.translation.z;
+      out.rotation[0] = in.transform.rotation.x;
+      out.rotation[1] = in.transform.rotation.y;
+      out.rotation[2] = in.transform.rotation.z;
+      out.rotation[3] = in.transform.rotation.w;
+    }
+
+    size_t transforms_size = transforms_buffer_.size() * sizeof(tf2_tools::TransformRecord);
+    writeHeader(tf2_tools::RECORD_MESSAGE, sizeof(message) + transforms_size);
+    write(&message, sizeof(message));
+    if (transforms_size)
+      write(&transforms_buffer_[0], transforms_size);
+
+    ++messages_;
+    transforms_ += msg.transforms.size();
+  }
+
+  uint32_t nameId(const std::string& name)
+  {
+    std::map<std::string, uint32_t>::const_iterator it = names_.find(name);
+    if (it != names_.end())
+      return it->second;
+
+    tf2_tools::NameRecord record;
+    record.id = names_.size();
+    record.length = name.size();
+    names_[name] = record.id;
+
+    writeHeader(tf2_tools::RECORD_NAME, sizeof(record) + name.size());
+    write(&record, sizeof(record));
+    write(name.data(), name.size());
+    pad(name.size());
+    return record.id;
+  }
+
+  void writeHeader(uint32_t type, size_t size)
+  {
+    tf2_tools::RecordHeader header;
+    header.type = type;
+    header.size = size;
+    write(&header, sizeof(header));
+  }
+
+  void pad(size_t size)
+  {
+    static const char zeros[8] = {0};
+    if (size % 8)
+      write(zeros, 8 - size % 8);
+  }
+
+  void write(const void* data, size_t size)
+  {
+    if (fwrite(data, 1, size, file_) != size)
+      ROS_ERROR_THROTTLE(1.0, "tf2_record failed to write the log");
+    bytes_ += size;
+  }
+
+  FILE* file_;
+  ros::NodeHandle node_;
+  ros::Subscriber subscriber_tf_, subscriber_tf_static_;
+  std::map<std::string, uint32_t> names_;
+  std::vector<tf2_tools::TransformRecord> transforms_buffer_;
+  unsigned long messages_;
+  unsigned long transforms_;
+  unsigned long bytes_;
+};
+
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "tf2_record", ros::init_options::AnonymousName);
+
+  if (argc != 2)
+  {
+    printf("Usage: tf2_record output_file\n");
+    printf("Records /tf and /tf_static into a compact binary log until shut down, to be played back with tf2_replay.\n");
+    return -1;
+  }
+
+  FILE* file = fopen(argv[1], "wb");
+  if (!file)
+  {
+    ROS_ERROR("tf2_record could not open %s", argv[1]);
+    return -1;
+  }
+  // Records are small, a large buffer keeps the recorder from making a syscall per message
+  static char file_buffer[1 << 20];
+  setvbuf(file, file_buffer, _IOFBF, sizeof(file_buffer));
+
+  {
+    TFRecorder recorder(file);
+    ros::spin();
+    recorder.printSummary();
+  }
+
+  fclose(file);
+  return 0;
+}
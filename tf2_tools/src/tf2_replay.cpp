@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tf_log.h"
+
+#include <tf2/buffer_core.h>
+#include <tf2/exceptions.h>
+#include <ros/time.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/** \brief One /tf or /tf_static message of a log */
+struct LoggedMessage
+{
+  ros::Time receipt_time;
+  std::string authority;
+  bool is_static;
+  std::vector<geometry_msgs::TransformStamped> transforms;
+};
+
+/** \brief A log mapped into memory, see tf_log.h for the format */
+class LogReader
+{
+public:
+  LogReader()
+  : data_(NULL)
+  , size_(0)
+  {
+  }
+
+  ~LogReader()
+  {
+    if (data_)
+      munmap(data_, size_);
+  }
+
+  bool open(const char* path)
+  {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+      fprintf(stderr, "Could not open %s\n", path);
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      size_ = st.st_size;
+      void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      data_ = (data == MAP_FAILED) ? NULL : (char*)data;
+    }
+    close(fd);
+    if (!data_)
+    {
+      fprintf(stderr, "Could not map %s\n", path);
+      return false;
+    }
+    return true;
+  }
+
+  size_t size() const { return size_; }
+
+  /** \brief Decode all messages of the log, a log cut short by a crashed recorder is read up to the cut */
+  bool read(std::vector<LoggedMessage>& messages) const
+  {
+    const tf2_tools::FileHeader* header = (const tf2_tools::FileHeader*)data_;
+    if (size_ < sizeof(*header) || memcmp(header->magic, tf2_tools::LOG_MAGIC, sizeof(header->magic)) != 0)
+    {
+      fprintf(stderr, "Not a tf2_record log\n");
+      return false;
+    }
+    if (header->version != tf2_tools::LOG_VERSION)
+    {
+      fprintf(stderr, "Unsupported log version %u\n", header->version);
+      return false;
+    }
+
+    std::vector<std::string> names;
+    size_t offset = sizeof(*header);
+    while (offset + sizeof(tf2_tools::RecordHeader) <= size_)
+    {
+      const tf2_tools::RecordHeader* record = (const tf2_tools::RecordHeader*)(data_ + offset);
+      if (offset + tf2_tools::recordSpan(record->size) > size_)
+        break;
+      const char* payload = data_ + offset + sizeof(*record);
+      offset += tf2_tools::recordSpan(record->size);
+
+      if (record->type == tf2_tools::RECORD_NAME)
+      {
+        const tf2_tools::NameRecord* name = (const tf2_tools::NameRecord*)payload;
+        // The recorder numbers the names in order, so a larger id can only come from a corrupt log
+        if (record->size < sizeof(*name) || sizeof(*name) + (size_t)name->length > record->size ||
+            name->id > names.size())
+        {
+          fprintf(stderr, "Corrupt name record at offset %lu\n", (unsigned long)offset);
+          return false;
+        }
+        if (name->id == names.size())
+          names.push_back(std::string());
+        names[name->id].assign(payload + sizeof(*name), name->length);
+      }
+      else if (record->type == tf2_tools::RECORD_MESSAGE)
+      {
+        const tf2_tools::MessageRecord* message = (const tf2_tools::MessageRecord*)payload;
+        const tf2_tools::TransformRecord* transforms = (const tf2_tools::TransformRecord*)(payload + sizeof(*message));
+        if (record->size < sizeof(*message) ||
+            sizeof(*message) + (size_t)message->count * sizeof(tf2_tools::TransformRecord) != record->size)
+        {
+          fprintf(stderr, "Corrupt message record at offset %lu\n", (unsigned long)offset);
+          return false;
+        }
+
+        messages.push_back(LoggedMessage());
+        LoggedMessage& out = messages.back();
+        out.receipt_time.fromNSec(message->receipt_time);
+        out.authority = lookupName(names, message->authority);
+        out.is_static = message->is_static;
+        out.transforms.resize(message->count);
+        for (uint32_t i = 0; i < message->count; ++i)
+        {
+          const tf2_tools::TransformRecord& in = transforms[i];
+          geometry_msgs::TransformStamped& transform = out.transforms[i];
+          transform.header.stamp.fromNSec(in.stamp);
+          transform.header.frame_id = lookupName(names, in.parent);
+          transform.child_frame_id = lookupName(names, in.child);
+          transform.transform.translation.x = in.translation[0];
+          transform.transform.translation.y = in.translation[1];
+          transform.transform.translation.z = in.translation[2];
+          transform.transform.rotation.x = in.rotation[0];
+          transform.transform.rotation.y = in.rotation[1];
+          transform.transform.rotation.z = in.rotation[2];
+          transform.transform.rotation.w = in.rotation[3];
+        }
+      }
+      // Unknown records are skipped, which leaves room to extend the format
+    }
+    return true;
+  }
+
+private:
+  static const std::string& lookupName(const std::vector<std::string>& names, uint32_t id)
+  {
+    static const std::string unknown;
+    return id < names.size() ? names[id] : unknown;
+  }
+
+  char* data_;
+  size_t size_;
+};
+
+/** \brief The root of the tree frame is in, following the parents which were last received */
+static std::string findRoot(const std::map<std::string, std::string>& parents, std::string frame)
+{
+  // A loop in the recording ends the walk after as many steps as there are frames
+  for (size_t i = 0; i <= parents.size(); ++i)
+  {
+    std::map<std::string, std::string>::const_iterator it = parents.find(frame);
+    if (it == parents.end())
+      break;
+    frame = it->second;
+  }
+  return frame;
+}
+
+static void printUsage()
+{
+  printf("Usage: tf2_replay log_file [--realtime] [--cache-time seconds]\n");
+  printf("Inserts a log written by tf2_record into a tf2::BufferCore, as fast as possible or with the\n");
+  printf("recorded timing, and reports the insert throughput. Then every recorded sample still in the\n");
+  printf("cache is looked up from the root of its tree, and the lookup throughput is reported.\n");
+}
+
+int main(int argc, char** argv)
+{
+  const char* path = NULL;
+  bool realtime = false;
+  double cache_time = tf2::BufferCore::DEFAULT_CACHE_TIME;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--realtime") == 0)
+      realtime = true;
+    else if (strcmp(argv[i], "--cache-time") == 0 && i + 1 < argc)
+      cache_time = atof(argv[++i]);
+    else if (!path && argv[i][0] != '-')
+      path = argv[i];
+    else
+    {
+      printUsage();
+      return -1;
+    }
+  }
+  if (!path)
+  {
+    printUsage();
+    return -1;
+  }
+
+  ros::Time::init();
+
+  // Decoding is done up front so that only BufferCore is measured below
+  LogReader reader;
+  std::vector<LoggedMessage> messages;
+  ros::WallTime start = ros::WallTime::now();
+  if (!reader.open(path) || !reader.read(messages))
+    return -1;
+  if (messages.empty())
+  {
+    printf("%s holds no messages\n", path);
+    return 0;
+  }
+  size_t transform_count = 0;
+  std::map<std::string, std::string> parents;
+  ros::Time latest_stamp;
+  for (size_t i = 0; i < messages.size(); ++i)
+  {
+    transform_count += messages[i].transforms.size();
+    for (size_t j = 0; j < messages[i].transforms.size(); ++j)
+    {
+      const geometry_msgs::TransformStamped& sample = messages[i].transforms[j];
+      parents[sample.child_frame_id] = sample.header.frame_id;
+      if (!messages[i].is_static)
+        latest_stamp = std::max(latest_stamp, sample.header.stamp);
+    }
+  }
+  ros::Duration recorded = messages.back().receipt_time - messages.front().receipt_time;
+  printf("Read %lu messages with %lu transforms of %lu frames, %.1f s of traffic, from %lu bytes in %.3f s\n",
+         (unsigned long)messages.size(), (unsigned long)transform_count, (unsigned long)parents.size(),
+         recorded.toSec(), (unsigned long)reader.size(), (ros::WallTime::now() - start).toSec());
+
+  ros::Duration cache_length(cache_time);
+  tf2::BufferCore buffer(cache_length);
+  double slowest_message = 0.0;
+  start = ros::WallTime::now();
+  for (size_t i = 0; i < messages.size(); ++i)
+  {
+    const LoggedMessage& message = messages[i];
+    if (realtime)
+    {
+      ros::WallTime due = start + ros::WallDuration((message.receipt_time - messages.front().receipt_time).toSec());
+      ros::WallTime now = ros::WallTime::now();
+      if (due > now)
+        (due - now).sleep();
+    }
+    ros::WallTime insert_start = ros::WallTime::now();
+    buffer.setTransforms(message.transforms, message.authority, message.is_static);
+    slowest_message = std::max(slowest_message, (ros::WallTime::now() - insert_start).toSec());
+  }
+  double insert_time = (ros::WallTime::now() - start).toSec();
+  printf("Insert: %.3f s, %.0f transforms/s, %.0f messages/s, slowest message %.1f us%s\n",
+         insert_time, transform_count / insert_time, messages.size() / insert_time, slowest_message * 1e6,
+         realtime ? " (recorded timing)" : "");
+
+  // Lookups of every dynamic sample which is still cached, in the order they were received
+  ros::Time oldest_cached = (latest_stamp.toSec() > cache_time) ? latest_stamp - cache_length : ros::Time();
+  std::map<std::string, std::string> roots;
+  for (std::map<std::string, std::string>::const_iterator it = parents.begin(); it != parents.end(); ++it)
+    roots[it->first] = findRoot(parents, it->first);
+  std::vector<const geometry_msgs::TransformStamped*> samples;
+  std::vector<const std::string*> targets;
+  for (size_t i = 0; i < messages.size(); ++i)
+  {
+    for (size_t j = 0; !messages[i].is_static && j < messages[i].transforms.size(); ++j)
+    {
+      const geometry_msgs::TransformStamped& sample = messages[i].transforms[j];
+      if (sample.header.stamp < oldest_cached)
+        continue;
+      samples.push_back(&sample);
+      targets.push_back(&roots[sample.child_frame_id]);
+    }
+  }
+
+  tf2::LookupContext context;
+  geometry_msgs::TransformStamped transform;
+  size_t failed = 0;
+  start = ros::WallTime::now();
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    try
+    {
+      buffer.lookupTransform(*targets[i], samples[i]->child_frame_id, samples[i]->header.stamp, transform, context);
+    }
+    catch (tf2::TransformException&)
+    {
+      // The rest of the chain may not reach back as far, as in a live system
+      ++failed;
+    }
+  }
+  double lookup_time = (ros::WallTime::now() - start).toSec();
+  printf("Lookup: %lu lookups from the root of each tree in %.3f s, %.0f lookups/s, %lu failed\n",
+         (unsigned long)samples.size(), lookup_time, samples.size() / std::max(lookup_time, 1e-9), (unsigned long)failed);
+
+  return 0;
+}
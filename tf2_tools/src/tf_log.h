@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TF2_TOOLS_TF_LOG_H
+#define TF2_TOOLS_TF_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** \brief Layout of the binary /tf logs written by tf2_record and read by tf2_replay.
+ *
+ * A log starts with a FileHeader, followed by records. Every record starts with a RecordHeader
+ * and is padded to a multiple of 8 bytes, so all structs stay aligned and a mapped log is read in
+ * place. Frame and authority names are stored once, in a RECORD_NAME, and referred to by id after.
+ * - RECORD_NAME: NameRecord, followed by the characters of the name
+ * - RECORD_MESSAGE: MessageRecord for one received tf2_msgs/TFMessage, followed by count TransformRecords
+ * Values are in the byte order of the recording host, times in nanoseconds.
+ */
+namespace tf2_tools
+{
+
+static const char LOG_MAGIC[8] = {'T', 'F', '2', 'L', 'O', 'G', '\0', '\0'};
+static const uint32_t LOG_VERSION = 1;
+
+enum RecordType
+{
+  RECORD_NAME = 1,
+  RECORD_MESSAGE = 2
+};
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct RecordHeader
+{
+  uint32_t type;
+  /// Bytes following the header, not counting the padding
+  uint32_t size;
+};
+
+struct NameRecord
+{
+  uint32_t id;
+  uint32_t length;
+};
+
+struct MessageRecord
+{
+  int64_t receipt_time;
+  uint32_t authority;
+  uint32_t count;
+  uint8_t is_static;
+  uint8_t reserved[7];
+};
+
+struct TransformRecord
+{
+  int64_t stamp;
+  uint32_t parent;
+  uint32_t child;
+  double translation[3];
+  double rotation[4];
+};
+
+/** \brief Bytes a record of the given size takes up in the log, with its header and padding
+ * Computed in size_t, as the size read from a corrupt log may be close to the 32 bit limit. */
+inline size_t recordSpan(uint32_t size)
+{
+  return sizeof(RecordHeader) + ((size_t(size) + 7) & ~size_t(7));
+}
+
+}
+
+#endif // TF2_TOOLS_TF_LOG_H